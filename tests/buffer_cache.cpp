@@ -0,0 +1,64 @@
+#include <detail/gfx_allocations.hpp>
+#include <test.hpp>
+#include <array>
+
+namespace {
+using namespace vf;
+using Range = BufferCache::Range;
+
+void merge_disjoint() {
+	auto ranges = BufferCache::Ranges{};
+	BufferCache::merge(ranges, {0, 4});
+	BufferCache::merge(ranges, {10, 12});
+	VF_EXPECT(ranges.size() == 2);
+	VF_EXPECT(ranges[0] == Range(0, 4) && ranges[1] == Range(10, 12));
+}
+
+void merge_overlapping() {
+	auto ranges = BufferCache::Ranges{};
+	BufferCache::merge(ranges, {4, 8});
+	BufferCache::merge(ranges, {2, 6});
+	VF_EXPECT(ranges.size() == 1 && ranges[0] == Range(2, 8));
+	// adjacent ranges coalesce
+	BufferCache::merge(ranges, {8, 10});
+	VF_EXPECT(ranges.size() == 1 && ranges[0] == Range(2, 10));
+	// contained ranges are absorbed
+	BufferCache::merge(ranges, {3, 5});
+	VF_EXPECT(ranges.size() == 1 && ranges[0] == Range(2, 10));
+}
+
+void merge_full() {
+	auto ranges = BufferCache::Ranges{};
+	for (std::size_t i = 0; i < ranges.capacity(); ++i) { BufferCache::merge(ranges, {i * 10, i * 10 + 2}); }
+	VF_EXPECT(ranges.size() == ranges.capacity());
+	// one more disjoint range: collapse everything into a single covering range
+	BufferCache::merge(ranges, {500, 510});
+	VF_EXPECT(ranges.size() == 1 && ranges[0] == Range(0, 510));
+}
+
+void write_bounds() {
+	// no device: only host data is exercised
+	auto cache = BufferCache{};
+	auto const bytes = std::array<std::byte, 8>{std::byte{1}, std::byte{2}, std::byte{3}, std::byte{4}};
+	cache.set(bytes.data(), bytes.size());
+	VF_EXPECT(cache.data.size() == bytes.size());
+	auto const version = cache.version;
+	auto const patch = std::array<std::byte, 2>{std::byte{9}, std::byte{9}};
+	VF_EXPECT(cache.write(2, patch.data(), patch.size()));
+	VF_EXPECT(cache.data[1] == std::byte{2} && cache.data[2] == std::byte{9} && cache.data[3] == std::byte{9} && cache.data[4] == std::byte{0});
+	// range writes do not invalidate copies entirely
+	VF_EXPECT(cache.version == version);
+	VF_EXPECT(!cache.write(7, patch.data(), patch.size()));
+	VF_EXPECT(cache.bytes().size() == bytes.size());
+	VF_EXPECT(cache.map(4).empty());
+	VF_EXPECT(!cache.acquire().resource);
+}
+} // namespace
+
+int main() {
+	merge_disjoint();
+	merge_overlapping();
+	merge_full();
+	write_bounds();
+	return vf::test::result();
+}
@@ -0,0 +1,90 @@
+#include <detail/render_pass.hpp>
+#include <test.hpp>
+#include <array>
+
+namespace {
+using namespace vf;
+
+// models.offset identifies each command (to check order after sorting)
+DrawCommand make_command(std::size_t id, bool depth_test, float z, bool opaque = true, Handle<Texture> texture = {}) {
+	auto ret = DrawCommand{};
+	ret.spec.depth_test = depth_test;
+	ret.spec.opaque = opaque;
+	ret.texture = texture;
+	ret.models = {id, 1};
+	ret.key = DrawList::make_key(ret.spec, texture, z);
+	return ret;
+}
+
+void make_key() {
+	auto const spec = PipelineFactory::Spec{};
+	// larger z is closer: closer draws sort first
+	VF_EXPECT(DrawList::make_key(spec, {}, 10.0f) < DrawList::make_key(spec, {}, -10.0f));
+	// depth is clamped to the projection's near / far planes
+	VF_EXPECT(DrawList::make_key(spec, {}, 500.0f) == DrawList::make_key(spec, {}, 100.0f));
+	VF_EXPECT(DrawList::make_key(spec, {}, -500.0f) == DrawList::make_key(spec, {}, -100.0f));
+	// pipeline and texture bits are independent of depth
+	VF_EXPECT((DrawList::make_key(spec, {}, 10.0f) >> 24) == (DrawList::make_key(spec, {}, -10.0f) >> 24));
+
+	auto image_a = GfxImage(nullptr);
+	auto image_b = GfxImage(nullptr);
+	auto const a = Handle<Texture>{&image_a};
+	auto const b = Handle<Texture>{&image_b};
+	VF_EXPECT(DrawList::make_key(spec, a, 0.0f) != DrawList::make_key(spec, b, 0.0f));
+	// pipeline bits are derived from every field of the spec
+	auto const pipe = [](PipelineFactory::Spec const& spec) { return DrawList::make_key(spec, {}, 0.0f) >> 48; };
+	auto lines = spec;
+	lines.topology = vk::PrimitiveTopology::eLineStrip;
+	VF_EXPECT(pipe(spec) != pipe(lines));
+	auto depth_tested = spec;
+	depth_tested.depth_test = true;
+	VF_EXPECT(pipe(spec) != pipe(depth_tested));
+	auto opaque = spec;
+	opaque.opaque = true;
+	VF_EXPECT(pipe(spec) != pipe(opaque));
+}
+
+void sort_opaque() {
+	auto list = DrawList{};
+	list.commands = {
+		make_command(0, true, -10.0f), make_command(1, true, 10.0f), make_command(2, false, 50.0f),
+		make_command(3, true, 0.0f),   make_command(4, true, 20.0f), make_command(5, false, -50.0f),
+	};
+	list.sort_opaque();
+	// each run of opaque depth tested draws is sorted front to back; other draws keep their position
+	static constexpr auto expected_v = std::array<std::size_t, 6>{1, 0, 2, 4, 3, 5};
+	VF_EXPECT(list.commands.size() == expected_v.size());
+	for (std::size_t i = 0; i < list.commands.size() && i < expected_v.size(); ++i) { VF_EXPECT(list.commands[i].models.offset == expected_v[i]); }
+}
+
+void sort_stable() {
+	auto list = DrawList{};
+	list.commands = {make_command(0, true, 5.0f), make_command(1, true, 5.0f), make_command(2, true, 5.0f)};
+	list.sort_opaque();
+	// equal keys retain submission order
+	for (std::size_t i = 0; i < list.commands.size(); ++i) { VF_EXPECT(list.commands[i].models.offset == i); }
+}
+void sort_blended() {
+	auto list = DrawList{};
+	// overlapping translucent sprites, back to front: reordering would let the depth test discard the farther ones
+	list.commands = {
+		make_command(0, true, -10.0f, false), make_command(1, true, 0.0f, false), make_command(2, true, 10.0f, false),
+		make_command(3, true, -5.0f),		  make_command(4, true, 5.0f),		  make_command(5, true, 20.0f, false),
+	};
+	list.sort_opaque();
+	// blended draws keep their position; only the opaque run is sorted
+	static constexpr auto expected_v = std::array<std::size_t, 6>{0, 1, 2, 4, 3, 5};
+	VF_EXPECT(list.commands.size() == expected_v.size());
+	for (std::size_t i = 0; i < list.commands.size() && i < expected_v.size(); ++i) { VF_EXPECT(list.commands[i].models.offset == expected_v[i]); }
+	VF_EXPECT(!DrawList::sortable(list.commands[0].spec));
+	VF_EXPECT(DrawList::sortable(list.commands[3].spec));
+}
+} // namespace
+
+int main() {
+	make_key();
+	sort_opaque();
+	sort_stable();
+	sort_blended();
+	return vf::test::result();
+}
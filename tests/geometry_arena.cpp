@@ -0,0 +1,104 @@
+#include <detail/gfx_allocations.hpp>
+#include <test.hpp>
+#include <memory>
+
+namespace {
+using namespace vf;
+using Block = GfxGeometryArena::Block;
+using Heap = GfxGeometryArena::Heap;
+
+static_assert(vertex_stride(VertexFormat::eStandard) == 32);
+static_assert(vertex_stride(VertexFormat::eCompact) == 16);
+static_assert(vertex_stride(VertexFormat::ePosition) == 8);
+
+bool equal(Block const a, Block const b) { return a.first == b.first && a.count == b.count; }
+
+void heap_allocate() {
+	auto heap = Heap{};
+	heap.grow(16);
+	VF_EXPECT(heap.capacity == 16 && heap.free.size() == 1);
+	VF_EXPECT(equal(heap.allocate(4), {0, 4}));
+	VF_EXPECT(equal(heap.allocate(4), {4, 4}));
+	// does not fit
+	VF_EXPECT(heap.allocate(9).count == 0);
+	VF_EXPECT(heap.allocate(0).count == 0);
+	VF_EXPECT(equal(heap.allocate(8), {8, 8}));
+	VF_EXPECT(heap.free.empty());
+}
+
+void heap_release() {
+	auto heap = Heap{};
+	heap.grow(16);
+	auto const a = heap.allocate(4);
+	auto const b = heap.allocate(4);
+	auto const c = heap.allocate(4);
+	heap.release(a);
+	heap.release(c);
+	// [0, 4) and [8, 16) are free: first fit
+	VF_EXPECT(heap.free.size() == 2);
+	VF_EXPECT(equal(heap.allocate(2), {0, 2}));
+	VF_EXPECT(equal(heap.allocate(4), {8, 4}));
+	heap.release({0, 2});
+	heap.release({8, 4});
+	// releasing b joins both neighbours
+	heap.release(b);
+	VF_EXPECT(heap.free.size() == 1 && equal(heap.free[0], {0, 16}));
+}
+
+void heap_grow() {
+	auto heap = Heap{};
+	heap.grow(8);
+	auto const all = heap.allocate(8);
+	heap.grow(16);
+	VF_EXPECT(heap.free.size() == 1 && equal(heap.free[0], {8, 8}));
+	// never shrinks
+	heap.grow(4);
+	VF_EXPECT(heap.capacity == 16);
+	heap.release(all);
+	VF_EXPECT(heap.free.size() == 1 && equal(heap.free[0], {0, 16}));
+}
+
+void storage_allocate() {
+	// no device: only host data is resized
+	auto storage = GfxGeometryArena::Storage{};
+	storage.vertices.grow(4);
+	auto const block = storage.allocate_vertices(10);
+	VF_EXPECT(block.count == 10);
+	// at least doubles
+	VF_EXPECT(storage.vertices.capacity == 14);
+	VF_EXPECT(storage.buffers[0].data.size() == 14 * storage.vertex_stride());
+
+	auto positions = GfxGeometryArena::Storage{};
+	positions.vertex_format = VertexFormat::ePosition;
+	positions.allocate_vertices(4);
+	VF_EXPECT(positions.buffers[0].data.size() == 4 * sizeof(glm::vec2));
+}
+
+void release() {
+	auto storage = std::make_shared<GfxGeometryArena::Storage>();
+	storage->vertices.grow(8);
+	storage->indices.grow(8);
+	auto const vertices = storage->vertices.allocate(8);
+	auto const indices = storage->indices.allocate(2);
+	{
+		auto release = GfxGeometryArena::Release(storage, vertices, indices);
+		VF_EXPECT(release);
+		auto moved = std::move(release);
+		// blocks are only returned once destroyed
+		VF_EXPECT(storage->vertices.free.empty());
+	}
+	// returned once (not by the moved from instance as well)
+	VF_EXPECT(storage->vertices.free.size() == 1 && equal(storage->vertices.free[0], {0, 8}));
+	VF_EXPECT(storage->indices.free.size() == 1 && equal(storage->indices.free[0], {0, 8}));
+	VF_EXPECT(!GfxGeometryArena::Release(storage, {}, {}));
+}
+} // namespace
+
+int main() {
+	heap_allocate();
+	heap_release();
+	heap_grow();
+	storage_allocate();
+	release();
+	return vf::test::result();
+}
@@ -0,0 +1,25 @@
+#include <detail/gfx_allocations.hpp>
+#include <test.hpp>
+#include <array>
+
+namespace {
+using namespace vf;
+
+// indices range over [0, vertices): 65536 vertices is the largest count addressable by 16 bit indices
+static_assert(GfxGeometryBuffer::fits_u16(0));
+static_assert(GfxGeometryBuffer::fits_u16(65536));
+static_assert(!GfxGeometryBuffer::fits_u16(65537));
+
+void narrow() {
+	auto const indices = std::array<std::uint32_t, 5>{0, 1, 2, 1000, 65535};
+	auto const narrowed = GfxGeometryBuffer::narrow(indices);
+	VF_EXPECT(narrowed.size() == indices.size());
+	for (std::size_t i = 0; i < indices.size() && i < narrowed.size(); ++i) { VF_EXPECT(narrowed[i] == indices[i]); }
+	VF_EXPECT(GfxGeometryBuffer::narrow({}).empty());
+}
+} // namespace
+
+int main() {
+	narrow();
+	return vf::test::result();
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <cstdio>
+
+namespace vf::test {
+inline int failures{};
+
+inline void expect(bool pred, char const* expr, char const* file, int line) {
+	if (pred) { return; }
+	std::fprintf(stderr, "%s:%d: expectation failed: %s\n", file, line, expr);
+	++failures;
+}
+
+inline int result() { return failures == 0 ? 0 : 1; }
+} // namespace vf::test
+
+#define VF_EXPECT(pred) ::vf::test::expect(static_cast<bool>(pred), #pred, __FILE__, __LINE__)
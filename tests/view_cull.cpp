@@ -0,0 +1,69 @@
+#include <detail/view_cull.hpp>
+#include <test.hpp>
+#include <array>
+
+namespace {
+using namespace vf;
+
+constexpr auto extent_v = glm::vec2{800.0f, 200.0f};
+
+// inverted camera: identity unless specified
+DrawModel make_view(glm::vec2 position = {}, glm::vec2 orientation = {1.0f, 0.0f}, float scale = 1.0f) {
+	return DrawModel{{position.x, position.y, orientation.x, orientation.y}, {scale, scale, 0.0f, 0.0f}};
+}
+
+void bounds() {
+	auto const cull = ViewCull::make(make_view(), extent_v);
+	VF_EXPECT(cull.test({}, glm::vec2{1.0f}, 0.0f));
+	VF_EXPECT(cull.test({399.0f, 99.0f}, glm::vec2{1.0f}, 0.0f));
+	VF_EXPECT(!cull.test({410.0f, 0.0f}, glm::vec2{1.0f}, 0.0f));
+	VF_EXPECT(!cull.test({0.0f, -110.0f}, glm::vec2{1.0f}, 0.0f));
+	// circles overlapping the edge are visible
+	VF_EXPECT(cull.test({410.0f, 0.0f}, glm::vec2{1.0f}, 20.0f));
+	// radius is scaled by the larger instance scale
+	VF_EXPECT(cull.test({0.0f, 130.0f}, glm::vec2{1.0f, 4.0f}, 10.0f));
+	VF_EXPECT(!cull.test({0.0f, 130.0f}, glm::vec2{1.0f}, 10.0f));
+}
+
+void view_transform() {
+	// camera moved right by 300: its view model translates by -300
+	auto const moved = ViewCull::make(make_view({-300.0f, 0.0f}), extent_v);
+	VF_EXPECT(moved.test({600.0f, 0.0f}, glm::vec2{1.0f}, 0.0f));
+	VF_EXPECT(!moved.test({-200.0f, 0.0f}, glm::vec2{1.0f}, 0.0f));
+
+	// view scale 2 (zoomed in): less of the world is visible
+	auto const zoomed = ViewCull::make(make_view({}, {1.0f, 0.0f}, 2.0f), extent_v);
+	VF_EXPECT(zoomed.max_scale == 2.0f);
+	VF_EXPECT(zoomed.test({150.0f, 0.0f}, glm::vec2{1.0f}, 0.0f));
+	VF_EXPECT(!zoomed.test({250.0f, 0.0f}, glm::vec2{1.0f}, 0.0f));
+
+	// rotated 90 degrees: world y maps onto the (wider) view x axis
+	auto const rotated = ViewCull::make(make_view({}, {0.0f, 1.0f}), extent_v);
+	VF_EXPECT(rotated.test({0.0f, 300.0f}, glm::vec2{1.0f}, 0.0f));
+	VF_EXPECT(!rotated.test({300.0f, 0.0f}, glm::vec2{1.0f}, 0.0f));
+}
+
+void mask() {
+	auto const cull = ViewCull::make(make_view(), extent_v);
+	auto instances = std::array<DrawInstance, 4>{};
+	instances[1].transform.position = {1000.0f, 0.0f};
+	instances[2].transform.position = {100.0f, 50.0f};
+	instances[3].transform.position = {0.0f, -1000.0f};
+	auto visible = std::array<std::uint8_t, 4>{};
+	VF_EXPECT(cull.mask(instances, 1.0f, visible.data()) == 2);
+	VF_EXPECT(visible[0] == 1 && visible[1] == 0 && visible[2] == 1 && visible[3] == 0);
+
+	auto models = std::array<DrawModel, 2>{};
+	models[0] = make_view({1000.0f, 0.0f});
+	models[1] = make_view({10.0f, 10.0f});
+	VF_EXPECT(cull.mask(models, 1.0f, visible.data()) == 1);
+	VF_EXPECT(visible[0] == 0 && visible[1] == 1);
+}
+} // namespace
+
+int main() {
+	bounds();
+	view_transform();
+	mask();
+	return vf::test::result();
+}
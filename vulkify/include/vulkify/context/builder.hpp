@@ -18,6 +18,7 @@ class Builder {
 	AntiAliasing anti_aliasing() const { return m_create_info.desired_aa; }
 	std::span<VSync const> vsyncs() const { return m_create_info.desired_vsyncs; }
 	ZOrder default_z_order() const { return m_create_info.default_z_order; }
+	std::string const& pipeline_cache() const { return m_pipeline_cache; }
 
 	Builder& set_title(std::string set);
 	Builder& set_extent(glm::uvec2 set);
@@ -29,6 +30,12 @@ class Builder {
 	Builder& set_select_gpu(SelectGpu select_gpu);
 	Builder& set_vsyncs(std::vector<VSync> desired);
 	Builder& set_default_z_order(ZOrder z_order);
+	///
+	/// \brief Set file path to load compiled pipelines from on startup and save them to on shutdown
+	///
+	/// Cache files created by a different GPU or driver version are ignored.
+	///
+	Builder& set_pipeline_cache(std::string path);
 
 	Context::Result build();
 
@@ -36,6 +43,7 @@ class Builder {
 	SelectGpu m_selec_gGpu{};
 	InstanceCreateInfo m_create_info{};
 	std::string m_title{"(Untitled)"};
+	std::string m_pipeline_cache{};
 };
 
 // impl
@@ -89,4 +97,9 @@ inline Builder& Builder::set_default_z_order(ZOrder z_order) {
 	m_create_info.default_z_order = z_order;
 	return *this;
 }
+
+inline Builder& Builder::set_pipeline_cache(std::string path) {
+	m_pipeline_cache = std::move(path);
+	return *this;
+}
 } // namespace vf
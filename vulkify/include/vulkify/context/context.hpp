@@ -35,6 +35,24 @@ class Context {
 	VSync vsync() const { return m_instance->vsync(); }
 
 	Frame frame(Rgba clear = {});
+	///
+	/// \brief Deliver completed frame readbacks (oldest first) without waiting on the GPU
+	///
+	std::size_t poll_readbacks(OnReadback const& callback) { return m_instance->poll_readbacks(callback); }
+	///
+	/// \brief Commands recorded / skipped (as redundant) during the last completed frame
+	///
+	RenderStats render_stats() const { return m_instance->render_stats(); }
+	///
+	/// \brief Create pipelines for states on a background thread, so first draws using them do not stall
+	///
+	/// Each state is also combined with each of shaders, for each of formats (VertexFormat::eStandard if empty).
+	/// Shaders must outlive the returned future.
+	/// \returns Future number of pipelines created
+	///
+	std::shared_future<std::size_t> prewarm(std::span<RenderState const> states, std::span<Handle<Shader> const> shaders = {}, std::span<VertexFormat const> formats = {}) {
+		return m_instance->prewarm(states, shaders, formats);
+	}
 
 	void set_position(glm::ivec2 xy) { m_instance->set_position(xy); }
 	void set_extent(glm::uvec2 size) { m_instance->set_extent(size); }
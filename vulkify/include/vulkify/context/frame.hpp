@@ -20,9 +20,22 @@ class Frame {
 	void draw(Primitive const& primitive, DescriptorSet const& descriptorSet) const { draw(primitive, {.descriptor_set = &descriptorSet}); }
 
 	Surface const& surface() const { return m_surface; }
+	///
+	/// \brief Obtain an additional Surface that records into its own command buffer, for drawing on another thread
+	///
+	/// Each call returns a distinct Surface; its draws are executed after this frame's own, in the order obtained.
+	/// Must be called on this frame's thread; the returned Surface must be destroyed before this frame is.
+	///
+	Surface worker_surface() const;
 	Camera camera() const;
 	void set_camera(Camera const& cam) const;
 
+	///
+	/// \brief Request a host copy of this frame's colour target, delivered later via Context::poll_readbacks()
+	/// \returns false if readback is unsupported or all readback slots are in flight
+	///
+	bool readback() const;
+
   private:
 	Frame(Surface&& surface, EventQueue poll, Time dt) noexcept : m_surface(std::move(surface)), m_poll(poll), m_dt(dt) {}
 
@@ -24,6 +24,8 @@ class DescriptorSet {
 	void write(std::vector<std::byte> uniform_data) { m_data.bytes = std::move(uniform_data); }
 	void write(Handle<Texture> texture) { m_data.texture = texture; }
 
+	Handle<Shader> shader() const { return m_shader; }
+
   private:
 	struct {
 		Handle<Texture> texture{};
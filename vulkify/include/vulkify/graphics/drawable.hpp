@@ -8,6 +8,8 @@
 
 namespace vf {
 class GeometryBuffer;
+class IndirectBuffer;
+class InstanceBuffer;
 class Texture;
 
 struct DrawInstance {
@@ -22,10 +24,24 @@ struct DrawInstance {
 ///
 /// \brief View to geometry, texture, and instances associated with a single draw call
 ///
+/// models (if non-empty) is used instead of instances, and uploaded without conversion.
+/// instance_buffer (if set) is used instead of both, and drawn from directly (no per-frame upload).
+///
 struct Drawable {
 	std::span<DrawInstance const> instances{};
 	Handle<GeometryBuffer> buffer{};
 	Handle<Texture> texture{};
+	std::span<DrawModel const> models{};
+	Handle<InstanceBuffer> instance_buffer{};
+};
+
+///
+/// \brief View to packed geometry, texture, and GPU resident draw arguments / instances associated with an indirect draw
+///
+struct IndirectDrawable {
+	Handle<GeometryBuffer> buffer{};
+	Handle<IndirectBuffer> indirect{};
+	Handle<Texture> texture{};
 };
 
 // impl
@@ -28,6 +28,38 @@ struct Vertex {
 	static constexpr Vertex make(glm::vec2 xy = {}, glm::vec2 uv = {}, glm::vec4 rgba = glm::vec4{1.0f}) { return {xy, uv, rgba}; }
 };
 
+///
+/// \brief Vertex layout in GPU buffers
+///
+enum class VertexFormat {
+	eStandard, // Vertex (32 bytes)
+	eCompact,  // CompactVertex (16 bytes)
+	ePosition, // glm::vec2 position only (8 bytes): texture coordinates are (0, 0) and vertex colour is white
+};
+
+///
+/// \brief A single vertex in half the size: half float texture coordinates and 8 bit colour channels
+///
+/// Expanded to the same shader inputs as Vertex by the vertex input stage.
+///
+struct CompactVertex {
+	///
+	/// \brief Vertex position
+	///
+	glm::vec2 xy;
+	///
+	/// \brief Texture coordinates (packed half floats)
+	///
+	std::uint32_t uv;
+	///
+	/// \brief Vertex colour
+	///
+	Rgba rgba;
+
+	static CompactVertex make(Vertex const& vertex);
+	Vertex vertex() const;
+};
+
 ///
 /// \brief Spec for quad shape
 ///
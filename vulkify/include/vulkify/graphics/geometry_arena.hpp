@@ -0,0 +1,30 @@
+#pragma once
+#include <vulkify/graphics/detail/gfx_deferred.hpp>
+#include <vulkify/graphics/geometry.hpp>
+#include <vulkify/graphics/handle.hpp>
+#include <cstdint>
+
+namespace vf {
+struct GfxDevice;
+
+///
+/// \brief Large vertex and index buffers shared by GeometryBuffers that sub-allocate from them
+///
+/// A GeometryBuffer constructed from an arena owns ranges of the arena's buffers instead of its own,
+/// and draws with vertexOffset / firstIndex; consecutive draws from the same arena keep the same buffer bindings.
+/// Buffers grow (at least doubling) when an allocation does not fit. Indices are always 32 bit.
+/// The buffers are shared with sub-allocations: GeometryBuffers allocated from an arena remain valid after it is destroyed.
+///
+class GeometryArena : public GfxDeferred {
+  public:
+	GeometryArena() = default;
+
+	explicit GeometryArena(GfxDevice const& device, VertexFormat format = VertexFormat::eStandard, std::uint32_t vertices = 4096, std::uint32_t indices = 4096);
+
+	VertexFormat vertex_format() const;
+	std::uint32_t vertex_capacity() const;
+	std::uint32_t index_capacity() const;
+
+	Handle<GeometryArena> handle() const;
+};
+} // namespace vf
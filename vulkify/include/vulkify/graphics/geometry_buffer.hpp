@@ -3,20 +3,69 @@
 #include <vulkify/graphics/detail/gfx_deferred.hpp>
 #include <vulkify/graphics/geometry.hpp>
 #include <vulkify/graphics/handle.hpp>
+#include <span>
 
 namespace vf {
 struct GfxDevice;
+class GeometryArena;
 
 ///
 /// \brief GPU Vertex (and index) buffer
 ///
+/// Usage::eDynamic: host visible buffers per frame in flight, rewritten on the next draw after write()
+/// Usage::eStatic: single device local buffer, uploaded once (via staging) in write(); for rarely modified geometry
+///   write_range() ranges are coalesced and uploaded (without stalling) before the render pass of the next frame drawing it:
+///   all draws in that frame see the new contents, including those submitted before the write_range()
+/// VertexFormat::eCompact: vertices are stored (and drawn) as CompactVertex, halving vertex memory / bandwidth
+/// VertexFormat::ePosition: only vertex positions are stored (a quarter of Vertex); for untextured, uncoloured geometry (tinted per instance)
+/// Constructed from a GeometryArena: vertices and indices are sub-allocated from the arena's shared buffers
+///
 class GeometryBuffer : public GfxDeferred {
   public:
+	enum class Usage { eDynamic, eStatic };
+
+	///
+	/// \brief Vertices and indices mapped directly into GPU visible memory
+	///
+	struct Mapped {
+		std::span<Vertex> vertices{};
+		// set instead of vertices for VertexFormat::eCompact
+		std::span<CompactVertex> compact_vertices{};
+		// set instead of vertices for VertexFormat::ePosition
+		std::span<glm::vec2> positions{};
+		std::span<std::uint32_t> indices{};
+	};
+
 	GeometryBuffer() = default;
 
-	explicit GeometryBuffer(GfxDevice const& device);
+	explicit GeometryBuffer(GfxDevice const& device, Usage usage = Usage::eDynamic, VertexFormat format = VertexFormat::eStandard);
+	///
+	/// \brief Sub-allocate from arena; map() is not supported
+	///
+	explicit GeometryBuffer(GeometryArena& arena);
 
 	Result<void> write(Geometry geometry);
+	///
+	/// \brief Overwrite vertices [first, first + vertices.size()) of the last write(); only the modified range is uploaded
+	///
+	Result<void> write_range(std::size_t first, std::span<Vertex const> vertices);
+	///
+	/// \brief Overwrite indices [first, first + indices.size()) of the last write(); only the modified range is uploaded
+	///
+	Result<void> write_range(std::size_t first, std::span<std::uint32_t const> indices);
+	///
+	/// \brief Obtain vertex_count vertices and index_count indices in buffers no frame in flight is using, to be written in place
+	///
+	/// Avoids the intermediate copy of write(); intended for geometry regenerated every frame (Usage::eDynamic only).
+	/// Every element must be written before the next draw of this buffer, and the spans must not be retained: they are
+	/// invalidated by the end of the current frame, or by the next map() / write() / write_range(). Mapped contents persist
+	/// until then (subsequent draws and geometry() use them) and write_range() applies on top of them.
+	/// Mapped geometry is never culled.
+	///
+	Result<Mapped> map(std::uint32_t vertex_count, std::uint32_t index_count = 0);
+
+	Usage usage() const;
+	VertexFormat vertex_format() const;
 
 	Geometry geometry() const;
 
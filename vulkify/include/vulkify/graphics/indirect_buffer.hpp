@@ -0,0 +1,57 @@
+#pragma once
+#include <vulkify/core/result.hpp>
+#include <vulkify/graphics/detail/gfx_deferred.hpp>
+#include <vulkify/graphics/drawable.hpp>
+#include <vulkify/graphics/handle.hpp>
+#include <cstdint>
+#include <span>
+
+namespace vf {
+struct GfxDevice;
+
+///
+/// \brief Arguments for one object in an indirect draw
+///
+/// Note: DrawIndirect objects are uploaded directly to indirect buffers
+///
+struct DrawIndirect {
+	///
+	/// \brief Number of indices of the object's geometry
+	///
+	std::uint32_t index_count{};
+	///
+	/// \brief Number of instances to draw
+	///
+	std::uint32_t instance_count{};
+	///
+	/// \brief Offset of the object's first index in the (packed) index buffer
+	///
+	std::uint32_t first_index{};
+	///
+	/// \brief Offset added to each index of the object
+	///
+	std::int32_t vertex_offset{};
+	///
+	/// \brief Offset of the object's first instance in the instance buffer
+	///
+	std::uint32_t first_instance{};
+};
+
+///
+/// \brief GPU buffers of per-object draw arguments and instances, consumed by indirect draws
+///
+/// Contents are only re-uploaded after write().
+///
+class IndirectBuffer : public GfxDeferred {
+  public:
+	IndirectBuffer() = default;
+
+	explicit IndirectBuffer(GfxDevice const& device);
+
+	Result<void> write(std::span<DrawIndirect const> commands, std::span<DrawInstance const> instances);
+
+	std::size_t command_count() const;
+
+	Handle<IndirectBuffer> handle() const;
+};
+} // namespace vf
@@ -0,0 +1,36 @@
+#pragma once
+#include <vulkify/core/result.hpp>
+#include <vulkify/graphics/detail/gfx_deferred.hpp>
+#include <vulkify/graphics/drawable.hpp>
+#include <vulkify/graphics/handle.hpp>
+#include <span>
+
+namespace vf {
+struct GfxDevice;
+
+///
+/// \brief Persistent GPU buffer of instances, drawn without any per-frame upload
+///
+/// write() replaces all instances; write_range() only uploads the modified instances.
+/// Unmodified contents cost no bandwidth across frames.
+///
+class InstanceBuffer : public GfxDeferred {
+  public:
+	InstanceBuffer() = default;
+
+	explicit InstanceBuffer(GfxDevice const& device);
+
+	Result<void> write(std::span<DrawInstance const> instances);
+	Result<void> write(std::span<DrawModel const> models);
+	///
+	/// \brief Overwrite instances [first, first + instances.size()), which must already exist
+	///
+	Result<void> write_range(std::size_t first, std::span<DrawInstance const> instances);
+	Result<void> write_range(std::size_t first, std::span<DrawModel const> models);
+
+	std::size_t size() const;
+
+	Handle<InstanceBuffer> handle() const;
+	operator Handle<InstanceBuffer>() const { return handle(); }
+};
+} // namespace vf
@@ -0,0 +1,138 @@
+#pragma once
+#include <vulkify/graphics/drawable.hpp>
+#include <cstring>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace vf {
+///
+/// \brief Instance storage in GPU layout: uploaded as-is (single memcpy), with no per-instance conversion
+///
+/// Elements are accessed through Ref / ConstRef proxies that read / write the packed DrawModel fields.
+///
+class ModelStorage {
+  public:
+	template <typename T>
+	class Proxy;
+	using Ref = Proxy<DrawModel>;
+	using ConstRef = Proxy<DrawModel const>;
+
+	ModelStorage() = default;
+	explicit ModelStorage(std::size_t count, DrawInstance const& instance = {}) : m_models(count, instance.draw_model()) {}
+
+	std::size_t size() const { return m_models.size(); }
+	bool empty() const { return m_models.empty(); }
+	void reserve(std::size_t count) { m_models.reserve(count); }
+	void resize(std::size_t count, DrawInstance const& instance = {}) { m_models.resize(count, instance.draw_model()); }
+	void clear() { m_models.clear(); }
+
+	Ref push_back(DrawInstance const& instance);
+	void pop_back() { m_models.pop_back(); }
+
+	Ref operator[](std::size_t index);
+	ConstRef operator[](std::size_t index) const;
+
+	std::span<DrawModel> models() { return m_models; }
+	std::span<DrawModel const> models() const { return m_models; }
+	operator std::span<DrawModel const>() const { return models(); }
+
+  private:
+	std::vector<DrawModel> m_models{};
+};
+
+///
+/// \brief Accessor proxy to a DrawModel in ModelStorage
+///
+template <typename T>
+class ModelStorage::Proxy {
+  public:
+	static constexpr bool mutable_v = !std::is_const_v<T>;
+
+	glm::vec2 position() const { return {m_model->pos_orn.x, m_model->pos_orn.y}; }
+	nvec2 orientation() const { return nvec2{m_model->pos_orn.z, m_model->pos_orn.w}; }
+	glm::vec2 scale() const { return {m_model->scl_z_tint.x, m_model->scl_z_tint.y}; }
+	float z_index() const { return m_model->scl_z_tint.z; }
+	Rgba tint() const;
+	Transform transform() const { return {position(), orientation(), scale()}; }
+	DrawInstance instance() const { return {transform(), z_index(), tint()}; }
+
+	Proxy const& set_position(glm::vec2 position) const requires(mutable_v);
+	Proxy const& set_orientation(nvec2 orientation) const requires(mutable_v);
+	Proxy const& set_scale(glm::vec2 scale) const requires(mutable_v);
+	Proxy const& set_z_index(float z_index) const requires(mutable_v);
+	Proxy const& set_tint(Rgba tint) const requires(mutable_v);
+	Proxy const& set_transform(Transform const& transform) const requires(mutable_v);
+	Proxy const& operator=(DrawInstance const& instance) const requires(mutable_v);
+
+	operator DrawInstance() const { return instance(); }
+	operator Proxy<DrawModel const>() const requires(mutable_v) { return Proxy<DrawModel const>{*m_model}; }
+
+  private:
+	explicit Proxy(T& model) : m_model(&model) {}
+
+	T* m_model{};
+
+	friend class ModelStorage;
+	friend class Proxy<DrawModel>;
+};
+
+// impl
+
+inline ModelStorage::Ref ModelStorage::push_back(DrawInstance const& instance) { return Ref{m_models.emplace_back(instance.draw_model())}; }
+inline ModelStorage::Ref ModelStorage::operator[](std::size_t index) { return Ref{m_models[index]}; }
+inline ModelStorage::ConstRef ModelStorage::operator[](std::size_t index) const { return ConstRef{m_models[index]}; }
+
+template <typename T>
+Rgba ModelStorage::Proxy<T>::tint() const {
+	std::uint32_t utint;
+	std::memcpy(&utint, &m_model->scl_z_tint.w, sizeof(utint));
+	return Rgba::make(utint);
+}
+
+template <typename T>
+auto ModelStorage::Proxy<T>::set_position(glm::vec2 position) const -> Proxy const& requires(mutable_v) {
+	m_model->pos_orn.x = position.x;
+	m_model->pos_orn.y = position.y;
+	return *this;
+}
+
+template <typename T>
+auto ModelStorage::Proxy<T>::set_orientation(nvec2 orientation) const -> Proxy const& requires(mutable_v) {
+	m_model->pos_orn.z = orientation.value().x;
+	m_model->pos_orn.w = orientation.value().y;
+	return *this;
+}
+
+template <typename T>
+auto ModelStorage::Proxy<T>::set_scale(glm::vec2 scale) const -> Proxy const& requires(mutable_v) {
+	m_model->scl_z_tint.x = scale.x;
+	m_model->scl_z_tint.y = scale.y;
+	return *this;
+}
+
+template <typename T>
+auto ModelStorage::Proxy<T>::set_z_index(float z_index) const -> Proxy const& requires(mutable_v) {
+	m_model->scl_z_tint.z = z_index;
+	return *this;
+}
+
+template <typename T>
+auto ModelStorage::Proxy<T>::set_tint(Rgba tint) const -> Proxy const& requires(mutable_v) {
+	auto const utint = tint.to_u32();
+	std::memcpy(&m_model->scl_z_tint.w, &utint, sizeof(utint));
+	return *this;
+}
+
+template <typename T>
+auto ModelStorage::Proxy<T>::set_transform(Transform const& transform) const -> Proxy const& requires(mutable_v) {
+	m_model->pos_orn = {transform.position, transform.orientation.value()};
+	return set_scale(transform.scale);
+}
+
+template <typename T>
+auto ModelStorage::Proxy<T>::operator=(DrawInstance const& instance) const -> Proxy const& requires(mutable_v) {
+	*m_model = instance.draw_model();
+	return *this;
+}
+} // namespace vf
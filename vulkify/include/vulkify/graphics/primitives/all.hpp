@@ -1,5 +1,6 @@
 #pragma once
 #include <vulkify/graphics/primitives/circle_shape.hpp>
+#include <vulkify/graphics/primitives/indirect_mesh.hpp>
 #include <vulkify/graphics/primitives/mesh.hpp>
 #include <vulkify/graphics/primitives/prop.hpp>
 #include <vulkify/graphics/primitives/quad_shape.hpp>
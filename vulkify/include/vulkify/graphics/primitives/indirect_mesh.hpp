@@ -0,0 +1,70 @@
+#pragma once
+#include <vulkify/graphics/drawable.hpp>
+#include <vulkify/graphics/geometry_buffer.hpp>
+#include <vulkify/graphics/indirect_buffer.hpp>
+#include <vulkify/graphics/primitive.hpp>
+#include <vector>
+
+namespace vf {
+class Texture;
+
+///
+/// \brief Scene container of many objects (each with its own geometry and instances) drawn through GPU indirect draws
+///
+/// Geometries are packed into one GeometryBuffer, and per-object draw arguments / instances into an IndirectBuffer;
+/// both are only re-uploaded when modified. The whole container is recorded as a single (multi-)draw-indirect call.
+/// All objects share the texture and RenderState.
+///
+class IndirectMesh : public Primitive, public GfxResource {
+  public:
+	using Id = std::uint32_t;
+
+	IndirectMesh() = default;
+	explicit IndirectMesh(GfxDevice const& device, Handle<Texture> texture = {});
+
+	///
+	/// \brief Append geometry to the packed buffer (non-indexed geometry is indexed sequentially)
+	/// \returns Id to pass to add_object()
+	///
+	Id add_geometry(Geometry const& geometry);
+	///
+	/// \brief Add an object drawing geometry once per instance
+	/// \returns Id to pass to instances()
+	///
+	Id add_object(Id geometry, std::vector<DrawInstance> instances = {});
+	///
+	/// \brief Obtain mutable instances of object (marks the mesh dirty)
+	///
+	std::vector<DrawInstance>& instances(Id object);
+	std::span<DrawInstance const> instances(Id object) const;
+	std::size_t object_count() const { return m_objects.size(); }
+	void clear();
+
+	void draw(Surface const& surface, RenderState const& state = {}) const override;
+
+	Handle<Texture> texture{};
+
+  private:
+	struct Range {
+		std::uint32_t first_index{};
+		std::uint32_t index_count{};
+		std::int32_t vertex_offset{};
+	};
+	struct Object {
+		Id geometry{};
+		std::vector<DrawInstance> instances{};
+	};
+
+	void refresh() const;
+
+	Geometry m_geometry{};
+	std::vector<Range> m_ranges{};
+	std::vector<Object> m_objects{};
+	mutable GeometryBuffer m_buffer{};
+	mutable IndirectBuffer m_indirect{};
+	mutable struct {
+		bool geometry{};
+		bool objects{};
+	} m_dirty{};
+};
+} // namespace vf
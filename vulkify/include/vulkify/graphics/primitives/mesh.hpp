@@ -1,6 +1,8 @@
 #pragma once
 #include <vulkify/graphics/drawable.hpp>
 #include <vulkify/graphics/geometry_buffer.hpp>
+#include <vulkify/graphics/instance_buffer.hpp>
+#include <vulkify/graphics/model_storage.hpp>
 #include <vulkify/graphics/primitive.hpp>
 #include <vulkify/graphics/surface.hpp>
 
@@ -8,11 +10,15 @@ namespace vf {
 class Texture;
 
 template <typename T>
-concept InstancedMeshStorage = std::convertible_to<T, std::span<DrawInstance const>>;
+concept InstancedMeshStorage =
+	std::convertible_to<T, std::span<DrawInstance const>> || std::convertible_to<T, std::span<DrawModel const>> || std::convertible_to<T, Handle<InstanceBuffer>>;
 
 ///
 /// \brief Low level primitive with public GeometryBuffer, Handle<Texture>, and std::vector<DrawInstance> (customizable)
 ///
+/// Storage convertible to std::span<DrawModel const> (eg ModelStorage) is uploaded without per-instance conversion.
+/// Storage convertible to Handle<InstanceBuffer> (eg InstanceBuffer) is GPU resident and only uploaded when modified.
+///
 template <InstancedMeshStorage Storage = std::vector<DrawInstance>>
 class InstancedMesh : public Primitive, public GfxResource {
   public:
@@ -20,11 +26,13 @@ class InstancedMesh : public Primitive, public GfxResource {
 
 	InstancedMesh() = default;
 
-	InstancedMesh(GfxDevice const& device, Handle<Texture> texture = {}) : GfxResource(&device), buffer(device), texture(texture) {}
+	InstancedMesh(GfxDevice const& device, Handle<Texture> texture = {}) : GfxResource(&device), buffer(device), texture(texture) {
+		if constexpr (std::constructible_from<Storage, GfxDevice const&>) { storage = Storage(device); }
+	}
 
 	void draw(Surface const& surface, RenderState const& state = {}) const override { surface.draw(drawable(), state); }
 
-	Drawable drawable() const { return {storage, buffer.handle(), texture}; }
+	Drawable drawable() const;
 
 	GeometryBuffer buffer{};
 	Handle<Texture> texture{};
@@ -50,4 +58,15 @@ InstancedMesh<Storage> InstancedMesh<Storage>::make_quad(GfxDevice const& device
 	ret.buffer.write(Geometry::make_quad(info));
 	return ret;
 }
+
+template <InstancedMeshStorage Storage>
+Drawable InstancedMesh<Storage>::drawable() const {
+	if constexpr (std::convertible_to<Storage, Handle<InstanceBuffer>>) {
+		return {{}, buffer.handle(), texture, {}, Handle<InstanceBuffer>(storage)};
+	} else if constexpr (std::convertible_to<Storage, std::span<DrawModel const>>) {
+		return {{}, buffer.handle(), texture, std::span<DrawModel const>(storage)};
+	} else {
+		return {storage, buffer.handle(), texture};
+	}
+}
 } // namespace vf
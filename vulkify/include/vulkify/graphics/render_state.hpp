@@ -15,5 +15,7 @@ struct RenderState {
 	float line_width{1.0f};
 	std::optional<ZOrder> force_z_order{};
 	Ptr<DescriptorSet const> descriptor_set{};
+	// disable alpha blending: depth tested opaque draws may be reordered front to back (InstanceFlag::eSortDraws)
+	bool opaque{false};
 };
 } // namespace vf
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+
+namespace vf {
+///
+/// \brief Commands recorded and skipped (as redundant) during a render pass, for profiling
+///
+struct RenderStats {
+	struct Counter {
+		std::uint32_t recorded{};
+		std::uint32_t skipped{};
+
+		void operator()(bool record) { ++(record ? recorded : skipped); }
+		Counter& operator+=(Counter const& rhs);
+	};
+
+	Counter pipelines{};
+	Counter descriptor_sets{};
+	Counter viewports{};
+	Counter line_widths{};
+	Counter vertex_buffers{};
+	Counter index_buffers{};
+	Counter dynamic_states{};
+	std::uint32_t draws{};
+
+	RenderStats& operator+=(RenderStats const& rhs);
+};
+
+// impl
+
+inline RenderStats::Counter& RenderStats::Counter::operator+=(Counter const& rhs) {
+	recorded += rhs.recorded;
+	skipped += rhs.skipped;
+	return *this;
+}
+
+inline RenderStats& RenderStats::operator+=(RenderStats const& rhs) {
+	pipelines += rhs.pipelines;
+	descriptor_sets += rhs.descriptor_sets;
+	viewports += rhs.viewports;
+	line_widths += rhs.line_widths;
+	vertex_buffers += rhs.vertex_buffers;
+	index_buffers += rhs.index_buffers;
+	dynamic_states += rhs.dynamic_states;
+	draws += rhs.draws;
+	return *this;
+}
+} // namespace vf
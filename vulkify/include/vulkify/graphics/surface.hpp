@@ -9,6 +9,7 @@
 
 namespace vf {
 struct RenderPass;
+struct DrawCommand;
 
 ///
 /// \brief Surface being rendered to in a pass
@@ -29,11 +30,19 @@ class Surface {
 	explicit operator bool() const;
 
 	bool draw(Drawable const& drawable, RenderState const& state = {}) const;
+	///
+	/// \brief Draw every object in drawable.indirect with a single (multi-)draw-indirect call
+	///
+	bool draw(IndirectDrawable const& drawable, RenderState const& state = {}) const;
 
   private:
 	void swap(Surface& rhs) noexcept { std::swap(m_render_pass, rhs.m_render_pass); }
 	bool bind(RenderState const& state) const;
-	bool draw(std::span<DrawModel const> models, Drawable const& drawable, RenderState const& state) const;
+	template <typename T>
+	bool push(DrawCommand cmd, RenderState const& state, std::span<T const> instances, bool cull) const;
+	bool record(DrawCommand const& cmd, std::span<DrawModel const> models) const;
+	bool record_indirect(DrawCommand const& cmd) const;
+	void flush() const;
 
 	RenderPass const* m_render_pass{};
 
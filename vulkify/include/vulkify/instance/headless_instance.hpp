@@ -2,15 +2,23 @@
 #include <vulkify/core/result.hpp>
 #include <vulkify/core/time.hpp>
 #include <vulkify/instance/instance.hpp>
+#include <vulkify/instance/instance_create_info.hpp>
 
 namespace vf {
 class HeadlessInstance : public Instance {
   public:
 	using Result = vf::Result<ktl::kunique_ptr<HeadlessInstance>>;
+	using CreateInfo = InstanceCreateInfo;
 
-	static Result make(Time autoclose = 2s) { return ktl::make_unique<HeadlessInstance>(autoclose); }
+	///
+	/// \brief Create a headless instance that renders to offscreen images
+	///
+	/// Falls back to an inactive instance (no rendering) if no suitable Vulkan device is available
+	///
+	static Result make(CreateInfo const& create_info = {}, Time autoclose = 2s);
 
 	HeadlessInstance(Time autoclose);
+	~HeadlessInstance();
 
 	GfxDevice const& gfx_device() const override;
 	Gpu const& gpu() const override { return m_gpu; }
@@ -23,7 +31,7 @@ class HeadlessInstance : public Instance {
 	glm::vec2 cursor_position() const override { return {}; }
 	MonitorList monitors() const override { return {}; }
 	WindowFlags window_flags() const override { return m_window_flags; }
-	AntiAliasing anti_aliasing() const override { return AntiAliasing::eNone; }
+	AntiAliasing anti_aliasing() const override;
 	VSync vsync() const override { return {}; }
 	std::vector<Gpu> gpu_list() const override { return {m_gpu}; }
 	ZOrder default_z_order() const override { return {}; }
@@ -32,7 +40,7 @@ class HeadlessInstance : public Instance {
 	void hide() override {}
 	void close() override {}
 	void set_position(glm::ivec2) override {}
-	void set_extent(glm::uvec2) override {}
+	void set_extent(glm::uvec2 extent) override { m_framebuffer_extent = m_window_extent = extent; }
 	void set_cursor_mode(CursorMode) override {}
 	Cursor make_cursor(Icon) override { return {}; }
 	void destroy_cursor(Cursor) override {}
@@ -45,8 +53,14 @@ class HeadlessInstance : public Instance {
 	void lock_aspect_ratio(bool) override {}
 
 	EventQueue poll() override { return std::move(m_event_queue); }
-	Surface begin_pass(Rgba) override { return {}; }
-	bool end_pass() override { return true; }
+	Surface begin_pass(Rgba clear) override;
+	bool end_pass() override;
+	Surface worker_surface() override;
+
+	bool request_readback() override;
+	std::size_t poll_readbacks(OnReadback const& callback) override;
+	RenderStats render_stats() const override;
+	std::shared_future<std::size_t> prewarm(std::span<RenderState const> states, std::span<Handle<Shader> const> shaders, std::span<VertexFormat const> formats) override;
 
 	EventQueue m_event_queue{};
 	glm::uvec2 m_framebuffer_extent{};
@@ -55,6 +69,8 @@ class HeadlessInstance : public Instance {
 	Camera m_camera{};
 
   private:
+	struct Impl;
+	ktl::kunique_ptr<Impl> m_impl{};
 	Gpu m_gpu = {"vulkify (headless)", {}, {}, {}, Gpu::Type::eOther};
 	Clock::time_point m_start = Clock::now();
 	Time m_autoclose{};
@@ -3,6 +3,8 @@
 #include <vulkify/core/rect.hpp>
 #include <vulkify/graphics/bitmap.hpp>
 #include <vulkify/graphics/camera.hpp>
+#include <vulkify/graphics/geometry.hpp>
+#include <vulkify/graphics/render_stats.hpp>
 #include <vulkify/graphics/surface.hpp>
 #include <vulkify/instance/cursor.hpp>
 #include <vulkify/instance/event.hpp>
@@ -11,10 +13,14 @@
 #include <vulkify/instance/icon.hpp>
 #include <vulkify/instance/instance_enums.hpp>
 #include <vulkify/instance/monitor.hpp>
+#include <vulkify/instance/readback.hpp>
+#include <future>
 #include <span>
 
 namespace vf {
 struct GfxDevice;
+struct RenderState;
+class Shader;
 
 class Instance {
   public:
@@ -58,6 +64,32 @@ class Instance {
 	virtual EventQueue poll() = 0;
 	virtual Surface begin_pass(Rgba clear) = 0;
 	virtual bool end_pass() = 0;
+	///
+	/// \brief Obtain a Surface that records into its own command buffer, for drawing on another thread
+	/// \returns Inactive Surface if no pass is active
+	///
+	virtual Surface worker_surface() = 0;
+
+	///
+	/// \brief Request a host copy of the colour target of the current pass
+	/// \returns false if no pass is active, readback is unsupported, or all readback slots are in flight
+	///
+	virtual bool request_readback() = 0;
+	///
+	/// \brief Invoke callback for each completed readback, oldest first; never blocks
+	/// \returns Number of readbacks delivered
+	///
+	virtual std::size_t poll_readbacks(OnReadback const& callback) = 0;
+	///
+	/// \brief Commands recorded / skipped during the last completed pass (including worker Surfaces)
+	///
+	virtual RenderStats render_stats() const = 0;
+
+	///
+	/// \brief Create pipelines for states (and each state with each of shaders) for each of formats on a background thread
+	/// \returns Future number of pipelines created
+	///
+	virtual std::shared_future<std::size_t> prewarm(std::span<RenderState const> states, std::span<Handle<Shader> const> shaders, std::span<VertexFormat const> formats) = 0;
 };
 
 using UInstance = ktl::kunique_ptr<Instance>;
@@ -7,7 +7,14 @@
 namespace vf {
 struct Gpu;
 
-enum class InstanceFlag { eAutoShow, eLinearSwapchain, eSuperSampling, eHeadless };
+///
+/// \brief Instance creation flags
+///
+/// eBatchDraws: merge consecutive draws sharing geometry, texture, and render state into single instanced draws
+/// eSortDraws: sort consecutive opaque depth-tested draws (RenderState::opaque) by pipeline, texture, and depth (front to back)
+/// eCullInstances: drop instances outside the camera's view before uploading them (indirect draws are not culled)
+///
+enum class InstanceFlag { eAutoShow, eLinearSwapchain, eSuperSampling, eHeadless, eBatchDraws, eSortDraws, eCullInstances };
 using InstanceFlags = ktl::enum_flags<InstanceFlag>;
 
 struct GpuSelector {
@@ -23,5 +30,7 @@ struct InstanceCreateInfo {
 	Ptr<GpuSelector const> gpu_selector{};
 	std::vector<VSync> desired_vsyncs{VSync::eAdaptive, VSync::eOn};
 	ZOrder default_z_order{ZOrder::eOff};
+	// path to load pipeline cache from / save to (none if null)
+	char const* pipeline_cache{};
 };
 } // namespace vf
@@ -0,0 +1,30 @@
+#pragma once
+#include <vulkify/graphics/image.hpp>
+#include <cstdint>
+#include <functional>
+
+namespace vf {
+///
+/// \brief Host copy of a rendered colour target
+///
+/// The bytes are only valid for the duration of the callback passed to poll_readbacks()
+///
+struct Readback {
+	enum class Order { eRgba, eBgra };
+
+	///
+	/// \brief Tightly packed pixel bytes, 4 channels per pixel, top row first
+	///
+	Image::View image{};
+	///
+	/// \brief Channel order of each pixel
+	///
+	Order order{};
+	///
+	/// \brief Index of the frame this was captured from
+	///
+	std::uint64_t frame{};
+};
+
+using OnReadback = std::function<void(Readback const&)>;
+} // namespace vf
@@ -49,6 +49,12 @@ class VulkifyInstance : public Instance {
 	EventQueue poll() override;
 	Surface begin_pass(Rgba clear) override;
 	bool end_pass() override;
+	Surface worker_surface() override;
+
+	bool request_readback() override;
+	std::size_t poll_readbacks(OnReadback const& callback) override;
+	RenderStats render_stats() const override;
+	std::shared_future<std::size_t> prewarm(std::span<RenderState const> states, std::span<Handle<Shader> const> shaders, std::span<VertexFormat const> formats) override;
 
   private:
 	struct Impl;
@@ -24,9 +24,10 @@ Context::Result Builder::build() {
 	auto instance = UInstance{};
 	auto selector = Selector(std::move(m_selec_gGpu));
 	m_create_info.title = m_title.c_str();
+	m_create_info.pipeline_cache = m_pipeline_cache.empty() ? nullptr : m_pipeline_cache.c_str();
 	if (selector.select) { m_create_info.gpu_selector = &selector; }
 	if (m_create_info.instance_flags.test(InstanceFlag::eHeadless)) {
-		auto inst = HeadlessInstance::make();
+		auto inst = HeadlessInstance::make(m_create_info);
 		if (!inst) { return inst.error(); }
 		instance = std::move(inst.value());
 	} else {
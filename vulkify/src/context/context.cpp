@@ -17,6 +17,16 @@ void Frame::set_camera(Camera const& cam) const {
 	if (m_surface.m_render_pass && m_surface.m_render_pass->cam.camera) { *m_surface.m_render_pass->cam.camera = cam; }
 }
 
+bool Frame::readback() const {
+	if (!m_surface.m_render_pass || !m_surface.m_render_pass->instance) { return false; }
+	return m_surface.m_render_pass->instance.value->request_readback();
+}
+
+Surface Frame::worker_surface() const {
+	if (!m_surface.m_render_pass || !m_surface.m_render_pass->instance) { return {}; }
+	return m_surface.m_render_pass->instance.value->worker_surface();
+}
+
 Context::Context(UInstance&& instance) noexcept : m_instance(std::move(instance)) {}
 
 auto Context::make(UInstance&& instance) -> Result {
@@ -1,6 +1,7 @@
 #pragma once
 #include <detail/defer_base.hpp>
 #include <ktl/kunique_ptr.hpp>
+#include <cstdint>
 #include <mutex>
 #include <vector>
 
@@ -32,6 +33,11 @@ class DeferQueue {
 	void decrement();
 	void clear();
 
+	///
+	/// \brief Number of calls to decrement() (once per frame)
+	///
+	std::uint64_t frame() const { return m_frame; }
+
   private:
 	template <typename T>
 	struct Model : DeferBase {
@@ -42,5 +48,6 @@ class DeferQueue {
 	std::vector<Entry> m_entries{};
 	std::vector<Entry> m_expired{};
 	ktl::kunique_ptr<std::mutex> m_mutex{};
+	std::uint64_t m_frame{};
 };
 } // namespace vf
@@ -2,20 +2,46 @@
 #include <detail/gfx_device.hpp>
 #include <detail/rotator.hpp>
 #include <detail/set_writer.hpp>
+#include <detail/upload_ring.hpp>
+#include <ktl/kunique_ptr.hpp>
 #include <detail/trace.hpp>
 #include <ktl/enumerate.hpp>
 #include <ktl/fixed_vector.hpp>
+#include <unordered_map>
 #include <vector>
 
 namespace vf {
 struct DescriptorAllocator {
 	struct Set {
-		UniqueBuffer buffers[SetWriter::Binding::eCOUNT_]{};
+		SetWriter::State state{};
 		vk::DescriptorSet set{};
 	};
+	///
+	/// \brief Identifies a set whose contents are constant for a frame: texture, upload ring buffer, storage buffer
+	///
+	struct SharedKey {
+		std::uint64_t image{};
+		vk::Sampler sampler{};
+		std::uint64_t buffer{};
+		std::uint64_t storage{};
+
+		bool operator==(SharedKey const&) const = default;
+
+		struct Hasher {
+			std::size_t operator()(SharedKey const& key) const {
+				auto const hash = std::hash<std::uint64_t>{};
+				auto ret = hash(key.image);
+				ret ^= hash(key.buffer) + 0x9e3779b9 + (ret << 6) + (ret >> 2);
+				ret ^= hash(key.storage) + 0x9e3779b9 + (ret << 6) + (ret >> 2);
+				ret ^= std::hash<VkSampler>{}(key.sampler) + 0x9e3779b9 + (ret << 6) + (ret >> 2);
+				return ret;
+			}
+		};
+	};
 	struct Pool {
 		std::vector<Set> sets{};
 		std::vector<vk::UniqueDescriptorPool> descriptor_pools{};
+		std::unordered_map<SharedKey, std::size_t, SharedKey::Hasher> shared{};
 	};
 
 	static constexpr std::size_t block_size_v = 64;
@@ -23,12 +49,13 @@ struct DescriptorAllocator {
 	GfxDevice vram{};
 	vk::DescriptorSetLayout layout{};
 	std::uint32_t number{};
+	UploadRing* ring{};
 
 	Rotator<Pool, 4> pools{};
 	std::size_t index{};
 
-	static DescriptorAllocator make(GfxDevice const& vram, vk::DescriptorSetLayout layout, std::uint32_t number) {
-		auto ret = DescriptorAllocator{vram, layout, number};
+	static DescriptorAllocator make(GfxDevice const& vram, vk::DescriptorSetLayout layout, std::uint32_t number, UploadRing* ring) {
+		auto ret = DescriptorAllocator{vram, layout, number, ring};
 		for (std::size_t i = 0; i < vram.buffering; ++i) {
 			auto pool = Pool{};
 			pool.descriptor_pools.push_back(ret.make_descriptor_pool());
@@ -40,7 +67,7 @@ struct DescriptorAllocator {
 	vk::UniqueDescriptorPool make_descriptor_pool() const {
 		if (!vram) { return {}; }
 		static constexpr vk::DescriptorPoolSize pool_sizes_v[] = {
-			{vk::DescriptorType::eUniformBuffer, block_size_v},
+			{vk::DescriptorType::eUniformBufferDynamic, block_size_v},
 			{vk::DescriptorType::eStorageBuffer, block_size_v},
 			{vk::DescriptorType::eCombinedImageSampler, block_size_v},
 		};
@@ -72,21 +99,33 @@ struct DescriptorAllocator {
 		}
 	}
 
-	Set& set() {
+	Set& set(std::size_t const at) {
 		auto& storage = pools.get();
-		storage.sets.reserve(index + 1);
-		while (storage.sets.size() <= index) { allocate(); }
-		return storage.sets[index];
+		storage.sets.reserve(at + 1);
+		while (storage.sets.size() <= at) { allocate(); }
+		return storage.sets[at];
+	}
+
+	SetWriter descriptor_set(std::size_t const at) {
+		auto& set = this->set(at);
+		return {&vram, ring, &set.state, set.set, number};
 	}
 
-	SetWriter descriptor_set() {
-		auto& set = this->set();
-		return {&vram, set.buffers, set.set, number};
+	///
+	/// \brief Obtain the set shared by every draw this frame with the same key (allocating one on first use)
+	///
+	/// Draws sharing a set differ only in dynamic offset / firstInstance, so it is never updated after being bound.
+	///
+	SetWriter shared_set(SharedKey const& key) {
+		auto [it, inserted] = pools.get().shared.try_emplace(key, index);
+		if (inserted) { ++index; }
+		return descriptor_set(it->second);
 	}
 
 	void next() {
 		pools.next();
 		index = {};
+		pools.get().shared.clear();
 	}
 };
 
@@ -94,27 +133,45 @@ struct DescriptorSetFactory {
 	static constexpr std::size_t sets_v = 3;
 
 	DescriptorAllocator allocators[sets_v]{};
+	ktl::kunique_ptr<UploadRing> ring{};
 
 	static DescriptorSetFactory make(GfxDevice const& gfx_device, std::span<vk::DescriptorSetLayout const> layouts) {
 		auto ret = DescriptorSetFactory{};
+		ret.ring = ktl::make_unique<UploadRing>(UploadRing::make(gfx_device));
 		for (auto const [layout, number] : ktl::enumerate<std::uint32_t>(layouts)) {
-			ret.allocators[number] = DescriptorAllocator::make(gfx_device, layout, number);
+			ret.allocators[number] = DescriptorAllocator::make(gfx_device, layout, number, ret.ring.get());
 		}
 		return ret;
 	}
 
-	explicit operator bool() const { return !allocators[0].pools.storage.empty(); }
+	explicit operator bool() const { return !allocators[0].pools.storage.empty() && ring && *ring; }
 
 	SetWriter post_increment(std::uint32_t set) {
 		assert(set < sets_v);
 		auto& rot = allocators[set];
-		auto ret = rot.descriptor_set();
+		auto ret = rot.descriptor_set(rot.index);
 		++rot.index;
 		return ret;
 	}
 
+	///
+	/// \brief Obtain the set for image shared across this frame's draws
+	///
+	/// A per-texture cache, not a bindless texture array: draws with different textures still use (and bind) different sets.
+	///
+	/// \param reserve Upload ring bytes the caller will write through the set (reserved up front so the ring buffer cannot change)
+	/// \param storage Id of the buffer bound to the storage binding, if not the upload ring
+	///
+	SetWriter shared(std::uint32_t set, CombinedImageSampler const& image, std::size_t reserve, std::uint64_t storage = {}) {
+		assert(set < sets_v);
+		if (!ring || !ring->reserve(reserve)) { return {}; }
+		auto const buffer = ring->buffer_id();
+		return allocators[set].shared_set({image.image, image.sampler, buffer, storage ? storage : buffer});
+	}
+
 	void next() {
 		for (auto& rotator : allocators) { rotator.next(); }
+		if (ring) { ring->next(); }
 	}
 };
 } // namespace vf
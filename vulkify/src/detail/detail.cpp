@@ -2,6 +2,7 @@
 #include <detail/gfx_allocations.hpp>
 #include <detail/gfx_command_buffer.hpp>
 #include <detail/gfx_device.hpp>
+#include <detail/staged_uploads.hpp>
 #include <detail/trace.hpp>
 #include <detail/vulkan_instance.hpp>
 #include <ktl/enumerate.hpp>
@@ -25,6 +26,7 @@ void DeferQueue::push_direct(Entry&& entry, int delay) {
 
 void DeferQueue::decrement() {
 	auto lock = std::scoped_lock(*m_mutex);
+	++m_frame;
 	std::erase_if(m_entries, [this](Entry& e) {
 		if (--e->delay <= 0) {
 			m_expired.push_back(std::move(e));
@@ -43,14 +45,17 @@ void DeferQueue::clear() {
 /// Device
 VulkanDevice VulkanDevice::make(VulkanInstance const& instance) {
 	assert(instance.util);
-	return VulkanDevice{
+	auto ret = VulkanDevice{
 		.queue = instance.queue,
 		.gpu = instance.gpu.device,
 		.device = *instance.device,
 		.queue_mutex = &instance.util->mutex.queue,
 		.limits = &instance.util->device_limits,
+		.features = &instance.util->device_features,
 		.flags = instance.messenger ? Flag::eDebugMsgr : Flags{},
 	};
+	ret.flags.assign(Flag::eDynamicState, instance.util->dynamic_state);
+	return ret;
 }
 
 void VulkanDevice::wait(vk::Fence fence, std::uint64_t wait) const {
@@ -160,7 +165,9 @@ Gpu make_gpu(vk::PhysicalDevice const& device, vk::SurfaceKHR surface) {
 	if (features.samplerAnisotropy) { ret.features.set(Gpu::Feature::eAnisotropicFiltering); }
 	if (features.sampleRateShading) { ret.features.set(Gpu::Feature::eMsaa); }
 	if (features.wideLines) { ret.features.set(Gpu::Feature::eWideLines); }
-	for (auto const mode : device.getSurfacePresentModesKHR(surface)) { ret.present_modes.set(to_vsync(mode)); }
+	if (surface) {
+		for (auto const mode : device.getSurfacePresentModesKHR(surface)) { ret.present_modes.set(to_vsync(mode)); }
+	}
 	return ret;
 }
 
@@ -172,9 +179,16 @@ constexpr std::array required_extensions_v = {
 #endif
 };
 
+// headless devices have no surface to present to: skip VK_KHR_swapchain (first entry)
+std::span<char const* const> required_extensions(bool headless) {
+	auto const ret = std::span<char const* const>(required_extensions_v);
+	return headless ? ret.subspan(1) : ret;
+}
+
 std::vector<PhysicalDevice> valid_devices(vk::Instance instance, vk::SurfaceKHR surface) {
-	auto const has_all_extensions = [](vk::PhysicalDevice const& device) {
-		auto remain = std::unordered_set<std::string_view>{required_extensions_v.begin(), required_extensions_v.end()};
+	auto const has_all_extensions = [surface](vk::PhysicalDevice const& device) {
+		auto const required = required_extensions(!surface);
+		auto remain = std::unordered_set<std::string_view>{required.begin(), required.end()};
 		for (auto const& extension : device.enumerateDeviceExtensionProperties()) {
 			auto const& name = extension.extensionName;
 			if (remain.contains(name)) { remain.erase(name); }
@@ -189,7 +203,7 @@ std::vector<PhysicalDevice> valid_devices(vk::Instance instance, vk::SurfaceKHR
 		static constexpr auto queue_flags_v = vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eTransfer;
 		auto const properties = device.getQueueFamilyProperties();
 		for (auto const& [props, family] : ktl::enumerate<std::uint32_t>(properties)) {
-			if (!device.getSurfaceSupportKHR(family, surface)) { continue; }
+			if (surface && !device.getSurfaceSupportKHR(family, surface)) { continue; }
 			if (!(props.queueFlags & queue_flags_v)) { continue; }
 			out_family = family;
 			return true;
@@ -210,22 +224,46 @@ std::vector<PhysicalDevice> valid_devices(vk::Instance instance, vk::SurfaceKHR
 	return ret;
 }
 
-vk::UniqueDevice make_device(std::span<char const*> layers, PhysicalDevice const& device) {
+vk::PhysicalDeviceFeatures enabled_features(vk::PhysicalDevice const& device) {
+	auto ret = vk::PhysicalDeviceFeatures{};
+	auto available = device.getFeatures();
+	ret.fillModeNonSolid = available.fillModeNonSolid;
+	ret.wideLines = available.wideLines;
+	ret.samplerAnisotropy = available.samplerAnisotropy;
+	ret.sampleRateShading = available.sampleRateShading;
+	ret.multiDrawIndirect = available.multiDrawIndirect;
+	ret.drawIndirectFirstInstance = available.drawIndirectFirstInstance;
+	return ret;
+}
+
+bool supports_dynamic_state(vk::PhysicalDevice const& device) {
+	if (device.getProperties().apiVersion < VK_API_VERSION_1_1) { return false; }
+	auto const extensions = device.enumerateDeviceExtensionProperties();
+	auto const match = [](vk::ExtensionProperties const& ext) { return std::string_view(ext.extensionName.data()) == VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME; };
+	if (std::find_if(extensions.begin(), extensions.end(), match) == extensions.end()) { return false; }
+	auto const chain = device.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT>();
+	return chain.get<vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT>().extendedDynamicState;
+}
+
+vk::UniqueDevice make_device(std::span<char const*> layers, PhysicalDevice const& device, bool headless, bool dynamic_state) {
 	static constexpr float priority_v = 1.0f;
 	auto qci = vk::DeviceQueueCreateInfo({}, device.queueFamily, 1, &priority_v);
 	auto dci = vk::DeviceCreateInfo{};
-	auto enabled = vk::PhysicalDeviceFeatures{};
-	auto available = device.device.getFeatures();
-	enabled.fillModeNonSolid = available.fillModeNonSolid;
-	enabled.wideLines = available.wideLines;
-	enabled.samplerAnisotropy = available.samplerAnisotropy;
-	enabled.sampleRateShading = available.sampleRateShading;
+	auto const enabled = enabled_features(device.device);
 	dci.queueCreateInfoCount = 1;
 	dci.pQueueCreateInfos = &qci;
 	dci.enabledLayerCount = static_cast<std::uint32_t>(layers.size());
 	dci.ppEnabledLayerNames = layers.data();
-	dci.enabledExtensionCount = static_cast<std::uint32_t>(required_extensions_v.size());
-	dci.ppEnabledExtensionNames = required_extensions_v.data();
+	auto const required = required_extensions(headless);
+	auto extensions = std::vector<char const*>(required.begin(), required.end());
+	auto edsf = vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT{};
+	if (dynamic_state) {
+		extensions.push_back(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME);
+		edsf.extendedDynamicState = true;
+		dci.pNext = &edsf;
+	}
+	dci.enabledExtensionCount = static_cast<std::uint32_t>(extensions.size());
+	dci.ppEnabledExtensionNames = extensions.data();
 	dci.pEnabledFeatures = &enabled;
 	return device.device.createDeviceUnique(dci);
 }
@@ -233,7 +271,7 @@ vk::UniqueDevice make_device(std::span<char const*> layers, PhysicalDevice const
 
 std::vector<Gpu> VulkanInstance::available_devices() const {
 	auto ret = std::vector<Gpu>{};
-	if (instance && surface) {
+	if (instance && (surface || headless)) {
 		auto devices = valid_devices(*instance, *surface);
 		ret.reserve(devices.size());
 		for (auto const& device : devices) { ret.push_back(make_gpu(device.device, *surface)); }
@@ -242,7 +280,7 @@ std::vector<Gpu> VulkanInstance::available_devices() const {
 }
 
 Result<VulkanInstance::Builder> VulkanInstance::Builder::make(Info info, bool validation) {
-	if (!info.make_surface) { return Error::eInvalidArgument; }
+	if (!info.headless && !info.make_surface) { return Error::eInvalidArgument; }
 	auto ret = Builder{};
 	auto dl = vk::DynamicLoader{};
 	VULKAN_HPP_DEFAULT_DISPATCHER.init(dl.getProcAddress<PFN_vkGetInstanceProcAddr>("vkGetInstanceProcAddr"));
@@ -250,9 +288,12 @@ Result<VulkanInstance::Builder> VulkanInstance::Builder::make(Info info, bool va
 	ret.validation = validation;
 	VULKAN_HPP_DEFAULT_DISPATCHER.init(*ret.instance.instance);
 	if (validation) { ret.instance.messenger = make_debug_messenger(*ret.instance.instance); }
-	auto surface = info.make_surface(*ret.instance.instance);
-	if (!surface) { return Error::eVulkanInitFailure; }
-	ret.instance.surface = vk::UniqueSurfaceKHR(surface, *ret.instance.instance);
+	ret.instance.headless = info.headless;
+	if (!info.headless) {
+		auto surface = info.make_surface(*ret.instance.instance);
+		if (!surface) { return Error::eVulkanInitFailure; }
+		ret.instance.surface = vk::UniqueSurfaceKHR(surface, *ret.instance.instance);
+	}
 	ret.devices = valid_devices(*ret.instance.instance, *ret.instance.surface);
 	if (ret.devices.empty()) { return Error::eNoVulkanSupport; }
 	return Result<Builder>(std::move(ret));
@@ -261,17 +302,21 @@ Result<VulkanInstance::Builder> VulkanInstance::Builder::make(Info info, bool va
 Result<VulkanInstance> VulkanInstance::Builder::operator()(PhysicalDevice&& selected) {
 	instance.gpu.gpu = std::move(selected.gpu);
 	instance.gpu.device = selected.device;
-	instance.gpu.formats = selected.device.getSurfaceFormatsKHR(*instance.surface);
+	if (instance.surface) { instance.gpu.formats = selected.device.getSurfaceFormatsKHR(*instance.surface); }
 	instance.gpu.properties = selected.device.getProperties();
 	auto layers = ktl::fixed_vector<char const*, 2>{};
 	if (validation) { layers.push_back(validation_layer_v.data()); }
-	instance.device = make_device(layers, selected);
+	auto const dynamic_state = supports_dynamic_state(selected.device);
+	instance.device = make_device(layers, selected, instance.headless, dynamic_state);
 	if (!instance.device) { return Error::eVulkanInitFailure; }
 
 	VULKAN_HPP_DEFAULT_DISPATCHER.init(*instance.device);
 	instance.queue = Queue{instance.device->getQueue(selected.queueFamily, 0), selected.queueFamily};
 	instance.util = ktl::make_unique<Util>();
 	instance.util->device_limits = instance.gpu.device.getProperties().limits;
+	instance.util->device_features = enabled_features(selected.device);
+	instance.util->dynamic_state = dynamic_state;
+	if (dynamic_state) { VF_TRACE("vf::(internal)", trace::Type::eInfo, "Using VK_EXT_extended_dynamic_state"); }
 	return std::move(instance);
 }
 /// /Instance
@@ -412,9 +457,9 @@ vk::ImageLayout ImageBarrier::operator()(vk::CommandBuffer cb, vk::Image image,
 	return operator()(cb, image, {vk::ImageLayout::eUndefined, target});
 }
 
-bool VmaBuffer::write(void const* data, std::size_t size) {
-	if (!map || this->size < size) { return false; }
-	std::memcpy(map, data, size);
+bool VmaBuffer::write(void const* data, std::size_t size, std::size_t offset) {
+	if (!map || this->size < offset + size) { return false; }
+	std::memcpy(static_cast<std::byte*>(map) + offset, data, size);
 	return true;
 }
 
@@ -453,12 +498,14 @@ UniqueGfxDevice UniqueGfxDevice::make(VulkanInstance const& instance, FT_Library
 	ret.colour_samples = get_samples(ret.device.limits->framebufferColorSampleCounts, samples);
 	ret.ftlib = ft;
 	ret.defer = &instance.util->defer;
+	ret.uploads = &instance.util->uploads;
 	return {std::move(factory), ret};
 }
 
 void GfxDevice::Deleter::operator()(GfxDevice const& device) const {
 	if (!device.device) { return; }
 	device.command_factory->clear();
+	device.uploads->clear();
 	device.defer->clear();
 	vmaDestroyAllocator(device.allocator);
 }
@@ -489,7 +536,7 @@ UniqueImage GfxDevice::make_image(vk::ImageCreateInfo info, bool host, bool line
 	return VmaImage{{vk::Image(ret), allocator, handle, id}, info.initialLayout, info.extent, info.tiling, caps};
 }
 
-UniqueBuffer GfxDevice::make_buffer(vk::BufferCreateInfo info, bool host) const {
+UniqueBuffer GfxDevice::make_buffer(vk::BufferCreateInfo info, bool host, bool readback) const {
 	if (!command_factory || !allocator) { return {}; }
 	info.sharingMode = vk::SharingMode::eExclusive;
 	info.queueFamilyIndexCount = 1U;
@@ -497,7 +544,7 @@ UniqueBuffer GfxDevice::make_buffer(vk::BufferCreateInfo info, bool host) const
 
 	auto vaci = VmaAllocationCreateInfo{};
 	vaci.usage = host ? VMA_MEMORY_USAGE_AUTO_PREFER_HOST : VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
-	if (host) { vaci.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT; }
+	if (host) { vaci.flags = readback ? VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT : VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT; }
 	auto const& vkBufferInfo = static_cast<VkBufferCreateInfo>(info);
 	auto ret = VkBuffer{};
 	auto handle = VmaAllocation{};
@@ -588,27 +635,274 @@ ImageView ImageCache::refresh(Extent const extent, vk::Format format) {
 	return peek();
 }
 
-BufferCache::BufferCache(GfxDevice const* device, vk::BufferUsageFlagBits usage) : device(device) {
+void BufferCache::merge(Ranges& ranges, Range range) {
+	auto it = std::find_if(ranges.begin(), ranges.end(), [range](Range const& r) { return r.first <= range.second && range.first <= r.second; });
+	if (it != ranges.end()) {
+		*it = {std::min(it->first, range.first), std::max(it->second, range.second)};
+	} else if (ranges.size() < ranges.capacity()) {
+		ranges.push_back(range);
+	} else {
+		// too many disjoint ranges: collapse into one
+		for (auto const& r : ranges) { range = {std::min(range.first, r.first), std::max(range.second, r.second)}; }
+		ranges.clear();
+		ranges.push_back(range);
+	}
+}
+
+BufferCache::BufferCache(GfxDevice const* device, vk::BufferUsageFlagBits usage, bool device_local) : device(device), device_local(device_local) {
 	info.usage = usage;
 	info.size = 1;
 	if (!device || !*device) { return; }
-	for (std::size_t i = 0; i < device->buffering; ++i) { buffers.push(device->make_buffer(info, true)); }
+	if (device_local) {
+		info.usage |= vk::BufferUsageFlagBits::eTransferDst;
+		return;
+	}
+	for (std::size_t i = 0; i < device->buffering; ++i) { copies.push_back(Copy{device->make_buffer(info, true)}); }
+}
+
+void BufferCache::set(void const* bytes, std::size_t size) {
+	mapped = false;
+	data.resize(size);
+	std::memcpy(data.data(), bytes, size);
+	++version;
+	if (device_local) { upload(); }
+}
+
+bool BufferCache::write(std::size_t offset, void const* bytes, std::size_t size) {
+	unmap();
+	if (offset + size > data.size()) { return false; }
+	if (size == 0) { return true; }
+	std::memcpy(data.data() + offset, bytes, size);
+	if (device_local) {
+		if (!local || local->size < data.size()) { return upload(); }
+		// coalesced with other writes and uploaded before the render pass of the next frame that draws this buffer
+		merge(staged, {offset, offset + size});
+		return true;
+	}
+	for (auto& copy : copies) {
+		// copies already out of date will be rewritten entirely
+		if (copy.written == version) { merge(copy.pending, {offset, offset + size}); }
+	}
+	return true;
+}
+
+bool BufferCache::upload() {
+	if (!device || !*device || data.empty()) { return false; }
+	auto staging = device->make_buffer(vk::BufferCreateInfo({}, data.size(), vk::BufferUsageFlagBits::eTransferSrc), true);
+	if (!staging || !staging->write(data.data(), data.size())) { return false; }
+	info.size = data.size();
+	auto buffer = device->make_buffer(info, false);
+	if (!buffer) { return false; }
+	{
+		auto cb = GfxCommandBuffer(device);
+		cb.cmd.copyBuffer(staging->resource, buffer->resource, vk::BufferCopy({}, {}, data.size()));
+		static constexpr auto dst_access_v = vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead;
+		auto const mb = vk::MemoryBarrier(vk::AccessFlagBits::eTransferWrite, dst_access_v);
+		cb.cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eVertexInput, {}, mb, {}, {});
+		// blocks until the copy has completed
+	}
+	// the previous buffer may still be in use by frames in flight
+	if (local) { device->defer->push(std::move(local)); }
+	local = std::move(buffer);
+	staged.clear();
+	return true;
+}
+
+void BufferCache::record(vk::CommandBuffer cb) const {
+	if (staged.empty() || !local || !device || !*device) { return; }
+	auto size = std::size_t{};
+	for (auto const& range : staged) { size += range.second - range.first; }
+	auto staging = device->make_buffer(vk::BufferCreateInfo({}, size, vk::BufferUsageFlagBits::eTransferSrc), true);
+	// staged ranges are retained on failure: retried when next drawn
+	if (!staging) { return; }
+	auto copies = ktl::fixed_vector<vk::BufferCopy, 8>{};
+	auto offset = vk::DeviceSize{};
+	for (auto const& range : staged) {
+		auto const count = range.second - range.first;
+		if (!staging->write(data.data() + range.first, count, offset)) { return; }
+		copies.push_back(vk::BufferCopy(offset, range.first, count));
+		offset += count;
+	}
+	cb.copyBuffer(staging->resource, local->resource, static_cast<std::uint32_t>(copies.size()), copies.data());
+	// read by this frame's submission
+	device->defer->push(std::move(staging));
+	staged.clear();
+}
+
+std::span<std::byte> BufferCache::map(std::size_t size) {
+	if (!device || !*device || device_local || size == 0) { return {}; }
+	// contents are replaced entirely: no need to copy back any previous mapping
+	mapped = false;
+	data.resize(size);
+	++version;
+	current = idle_copy(frame());
+	auto& copy = copies[current];
+	if (!copy.buffer || copy.buffer->size < size) {
+		info.size = size;
+		if (copy.buffer) { device->defer->push(std::move(copy.buffer)); }
+		copy.buffer = device->make_buffer(info, true);
+	}
+	if (!copy.buffer || !copy.buffer->map) { return {}; }
+	copy.written = version;
+	copy.pending.clear();
+	// the mapped copy is (by definition) up to date; others are rewritten from data (after unmap()) if used
+	mapped = true;
+	return {static_cast<std::byte*>(copy.buffer->map), size};
+}
+
+void BufferCache::unmap() {
+	if (!mapped) { return; }
+	mapped = false;
+	auto const& copy = copies[current];
+	if (copy.buffer && copy.buffer->map) { std::memcpy(data.data(), copy.buffer->map, data.size()); }
+}
+
+std::span<std::byte const> BufferCache::bytes() const {
+	if (mapped) {
+		auto const& copy = copies[current];
+		if (copy.buffer && copy.buffer->map) { return {static_cast<std::byte const*>(copy.buffer->map), data.size()}; }
+	}
+	return data;
+}
+
+void BufferCache::resize(std::size_t size) {
+	unmap();
+	data.resize(size);
+	++version;
+}
+
+std::uint64_t BufferCache::frame() const { return device && device->defer ? device->defer->frame() : 0; }
+
+std::size_t BufferCache::idle_copy(std::uint64_t frame) const {
+	// a copy acquired in a frame may be read by the GPU until buffering frames later
+	auto const idle = [this, frame](Copy const& copy) { return copy.used == 0 || copy.used + device->buffering <= frame; };
+	// prefer copies only missing a few ranges
+	for (std::size_t i = 0; i < copies.size(); ++i) {
+		if (idle(copies[i]) && copies[i].written == version) { return i; }
+	}
+	for (std::size_t i = 0; i < copies.size(); ++i) {
+		if (idle(copies[i])) { return i; }
+	}
+	copies.push_back(Copy{});
+	return copies.size() - 1;
+}
+
+void BufferCache::refresh(Copy& copy) const {
+	if (!copy.buffer || copy.buffer->size < data.size()) {
+		info.size = data.size();
+		if (copy.buffer) { device->defer->push(std::move(copy.buffer)); }
+		copy.buffer = device->make_buffer(info, true);
+		copy.written = {};
+	}
+	if (!copy.buffer) { return; }
+	if (copy.written != version) {
+		copy.buffer->write(data.data(), data.size());
+		copy.written = version;
+	} else {
+		for (auto const& range : copy.pending) { copy.buffer->write(data.data() + range.first, range.second - range.first, range.first); }
+	}
+	copy.pending.clear();
 }
 
-VmaBuffer const& BufferCache::get(bool next) const {
+VmaBuffer const& BufferCache::acquire() const {
 	static auto const blank_v = VmaBuffer{};
 	if (!device || !*device) { return blank_v; }
-	auto& buffer = buffers.get();
-	if (buffer->size < data.size()) {
-		info.size = data.size();
-		device->defer->push(std::move(buffer));
-		buffer = device->make_buffer(info, true);
+	if (device_local) {
+		if (!staged.empty() && device->uploads) { device->uploads->push(this); }
+		return local ? local.get() : blank_v;
+	}
+	auto const frame = this->frame();
+	auto const stale = [this](Copy const& copy) { return !copy.buffer || copy.written != version || !copy.pending.empty(); };
+	if (copies.empty() || (!mapped && stale(copies[current]))) {
+		current = idle_copy(frame);
+		refresh(copies[current]);
+	}
+	auto& copy = copies[current];
+	if (!copy.buffer) { return blank_v; }
+	copy.used = frame;
+	return copy.buffer;
+}
+
+void StagedUploads::push(BufferCache const* cache) {
+	auto lock = std::scoped_lock(*m_mutex);
+	if (std::find(m_caches.begin(), m_caches.end(), cache) == m_caches.end()) { m_caches.push_back(cache); }
+}
+
+void StagedUploads::record(vk::CommandBuffer cb) {
+	auto lock = std::scoped_lock(*m_mutex);
+	if (m_caches.empty()) { return; }
+	static constexpr auto read_access_v = vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead;
+	// frames in flight (submitted earlier) may still be reading these buffers
+	auto const before = vk::MemoryBarrier({}, vk::AccessFlagBits::eTransferWrite);
+	cb.pipelineBarrier(vk::PipelineStageFlagBits::eVertexInput, vk::PipelineStageFlagBits::eTransfer, {}, before, {}, {});
+	for (auto const* cache : m_caches) { cache->record(cb); }
+	auto const after = vk::MemoryBarrier(vk::AccessFlagBits::eTransferWrite, read_access_v);
+	cb.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eVertexInput, {}, after, {}, {});
+	m_caches.clear();
+}
+
+void StagedUploads::clear() {
+	auto lock = std::scoped_lock(*m_mutex);
+	m_caches.clear();
+}
+
+auto GfxGeometryArena::Heap::allocate(std::uint32_t count) -> Block {
+	if (count == 0) { return {}; }
+	auto it = std::find_if(free.begin(), free.end(), [count](Block const& b) { return b.count >= count; });
+	if (it == free.end()) { return {}; }
+	auto const ret = Block{it->first, count};
+	it->first += count;
+	it->count -= count;
+	if (it->count == 0) { free.erase(it); }
+	return ret;
+}
+
+void GfxGeometryArena::Heap::release(Block block) {
+	if (block.count == 0) { return; }
+	auto it = std::lower_bound(free.begin(), free.end(), block.first, [](Block const& b, std::uint32_t first) { return b.first < first; });
+	it = free.insert(it, block);
+	if (auto next = it + 1; next != free.end() && it->first + it->count == next->first) {
+		it->count += next->count;
+		free.erase(next);
+	}
+	if (it != free.begin()) {
+		if (auto prev = it - 1; prev->first + prev->count == it->first) {
+			prev->count += it->count;
+			free.erase(it);
+		}
 	}
-	buffer->write(data.data(), data.size());
-	if (next) { buffers.next(); }
-	return buffer;
 }
 
+void GfxGeometryArena::Heap::grow(std::uint32_t capacity) {
+	if (capacity <= this->capacity) { return; }
+	release({this->capacity, capacity - this->capacity});
+	this->capacity = capacity;
+}
+
+auto GfxGeometryArena::Storage::allocate(Heap& heap, BufferCache& cache, std::size_t stride, std::uint32_t count) -> Block {
+	if (auto ret = heap.allocate(count); ret.count > 0 || count == 0) { return ret; }
+	// at least double the capacity, so that repeated growth is amortised
+	heap.grow(std::max(heap.capacity * 2, heap.capacity + count));
+	cache.resize(heap.capacity * stride);
+	return heap.allocate(count);
+}
+
+GfxGeometryArena::Release::~Release() {
+	if (!storage) { return; }
+	storage->vertices.release(vertices);
+	storage->indices.release(indices);
+}
+
+GfxGeometryBuffer::~GfxGeometryBuffer() {
+	// destroyed via DeferQueue (after frames in flight): release blocks directly
+	if (!arena) { return; }
+	arena->vertices.release(vertex_block);
+	arena->indices.release(index_block);
+}
+
+vk::Buffer GfxGeometryBuffer::vbo() const { return (arena ? arena->buffers[0] : buffers[0]).acquire().resource; }
+vk::Buffer GfxGeometryBuffer::ibo() const { return (arena ? arena->buffers[1] : buffers[1]).acquire().resource; }
+
 void GfxImage::replace(ImageCache&& cache) {
 	device()->defer->push(std::move(image.cache));
 	image.cache = std::move(cache);
@@ -3,6 +3,11 @@
 #include <detail/gfx_device.hpp>
 #include <detail/rotator.hpp>
 #include <detail/trace.hpp>
+#include <vulkify/graphics/geometry.hpp>
+#include <limits>
+#include <memory>
+#include <span>
+#include <utility>
 
 namespace vf {
 struct ImageCache {
@@ -39,15 +44,92 @@ struct ImageCache {
 };
 
 struct BufferCache {
+	// byte range [first, second)
+	using Range = std::pair<std::size_t, std::size_t>;
+	using Ranges = ktl::fixed_vector<Range, 8>;
+
+	///
+	/// \brief Host visible copy of data
+	///
+	struct Copy {
+		UniqueBuffer buffer{};
+		// version of data last written in full
+		std::uint64_t written{};
+		// frame this copy was last acquired in (0 if never): not modified until that frame is no longer in flight
+		std::uint64_t used{};
+		// ranges modified by write() that this (otherwise up to date) copy is yet to receive
+		Ranges pending{};
+	};
+
 	GfxDevice const* device{};
 	mutable vk::BufferCreateInfo info{};
-	mutable Rotator<UniqueBuffer, 4> buffers{};
+	mutable std::vector<Copy> copies{};
+	mutable std::size_t current{};
 	std::vector<std::byte> data{std::byte{}};
+	// bumped by set(): each copy is only rewritten when it is out of date
+	std::uint64_t version{1};
+	// static data: a single device local buffer, replaced on each set() and updated in place on each write() (via StagedUploads)
+	UniqueBuffer local{};
+	// ranges of data written since local was last uploaded to
+	mutable Ranges staged{};
+	bool device_local{};
+	// copies[current] was returned by map(): it is authoritative and data is stale until unmap()
+	bool mapped{};
+
+	///
+	/// \brief Merge range into ranges (coalescing overlapping / adjacent ones, collapsing all when full)
+	///
+	static void merge(Ranges& ranges, Range range);
 
 	BufferCache() = default;
-	BufferCache(GfxDevice const* device, vk::BufferUsageFlagBits usage);
+	BufferCache(GfxDevice const* device, vk::BufferUsageFlagBits usage, bool device_local = false);
+
+	void set(void const* bytes, std::size_t size);
+	///
+	/// \brief Overwrite size bytes at offset (within current data); only this range is uploaded to each copy
+	///
+	bool write(std::size_t offset, void const* bytes, std::size_t size);
+	///
+	/// \brief Obtain an up to date copy for use in the current frame
+	///
+	/// Device local: returns the local buffer, queueing any staged ranges for upload before the frame's render pass.
+	/// Otherwise returns the current copy if it is up to date, else refreshes one not in use by any frame in flight
+	/// (allocating a new copy if none is available). Repeated calls in a frame without intervening writes
+	/// return the same buffer, and a copy acquired in a frame is never modified until that frame has completed.
+	///
+	VmaBuffer const& acquire() const;
+	///
+	/// \brief Resize data (preserving contents); every copy is rewritten on its next use
+	///
+	void resize(std::size_t size);
+	///
+	/// \brief Obtain size bytes of a copy not in use by any frame in flight, for direct writes
+	///
+	/// The returned copy becomes current and authoritative: data is resized to match but not copied into
+	/// until unmap() (called implicitly by write() / resize(); set() / map() discard it).
+	///
+	std::span<std::byte> map(std::size_t size);
+	///
+	/// \brief Copy a mapped copy back into data (no-op if not mapped)
+	///
+	void unmap();
+	///
+	/// \brief Current contents (the mapped copy if mapped)
+	///
+	std::span<std::byte const> bytes() const;
+	///
+	/// \brief Upload data into a new device local buffer (the previous one is deferred)
+	///
+	bool upload();
+	///
+	/// \brief Record transfers of staged ranges into local (via a staging buffer released after the frame completes)
+	///
+	void record(vk::CommandBuffer cb) const;
 
-	VmaBuffer const& get(bool next) const;
+  private:
+	std::uint64_t frame() const;
+	std::size_t idle_copy(std::uint64_t frame) const;
+	void refresh(Copy& copy) const;
 };
 
 struct VulkanImage {
@@ -67,12 +149,109 @@ class GfxBuffer : public GfxAllocation {
 	BufferCache buffers[Count]{};
 };
 
+constexpr std::size_t vertex_stride(VertexFormat format) {
+	switch (format) {
+	case VertexFormat::eCompact: return sizeof(CompactVertex);
+	case VertexFormat::ePosition: return sizeof(glm::vec2);
+	default: return sizeof(Vertex);
+	}
+}
+
+class GfxGeometryArena : public GfxAllocation {
+  public:
+	// range of elements [first, first + count)
+	struct Block {
+		std::uint32_t first{};
+		std::uint32_t count{};
+	};
+
+	///
+	/// \brief First fit free list over a buffer's elements
+	///
+	struct Heap {
+		// sorted by first, never adjacent
+		std::vector<Block> free{};
+		std::uint32_t capacity{};
+
+		// count == 0 on failure
+		Block allocate(std::uint32_t count);
+		void release(Block block);
+		void grow(std::uint32_t capacity);
+	};
+
+	///
+	/// \brief Buffers and free lists, shared by the arena and all its sub-allocations (destroyed with the last of them)
+	///
+	struct Storage {
+		BufferCache buffers[2]{};
+		Heap vertices{};
+		Heap indices{};
+		VertexFormat vertex_format{};
+
+		///
+		/// \brief Allocate count vertices / indices, growing the buffer if required
+		///
+		Block allocate_vertices(std::uint32_t count) { return allocate(vertices, buffers[0], vertex_stride(), count); }
+		Block allocate_indices(std::uint32_t count) { return allocate(indices, buffers[1], sizeof(std::uint32_t), count); }
+
+		std::size_t vertex_stride() const { return vf::vertex_stride(vertex_format); }
+
+	  private:
+		static Block allocate(Heap& heap, BufferCache& cache, std::size_t stride, std::uint32_t count);
+	};
+
+	///
+	/// \brief Blocks returned to storage's heaps on destruction (pushed to DeferQueue: frames in flight may still read them)
+	///
+	struct Release {
+		std::shared_ptr<Storage> storage{};
+		Block vertices{};
+		Block indices{};
+
+		Release(std::shared_ptr<Storage> storage, Block vertices, Block indices) : storage(std::move(storage)), vertices(vertices), indices(indices) {}
+		Release(Release&&) = default;
+		Release& operator=(Release&&) = delete;
+		~Release();
+
+		explicit operator bool() const { return storage && (vertices.count > 0 || indices.count > 0); }
+	};
+
+	GfxGeometryArena(GfxDevice const* device) : GfxAllocation(device, Type::eBuffer), storage(std::make_shared<Storage>()) {
+		for (auto& buffer : storage->buffers) { buffer.device = device; }
+	}
+
+	std::shared_ptr<Storage> storage{};
+};
+
 class GfxGeometryBuffer : public GfxBuffer<2> {
   public:
 	using GfxBuffer::GfxBuffer;
+	~GfxGeometryBuffer() override;
+
+	///
+	/// \brief Whether every index into vertices fits in 16 bits
+	///
+	static constexpr bool fits_u16(std::size_t vertices) { return vertices <= std::size_t{std::numeric_limits<std::uint16_t>::max()} + 1; }
+	static std::vector<std::uint16_t> narrow(std::span<std::uint32_t const> indices);
+
+	///
+	/// \brief Vertex / index buffer to bind: own, or arena's (shared by all its sub-allocations)
+	///
+	vk::Buffer vbo() const;
+	vk::Buffer ibo() const;
+
+	// sub-allocation of arena (if set): own buffers are unused, draws offset by the blocks' first elements
+	std::shared_ptr<GfxGeometryArena::Storage> arena{};
+	GfxGeometryArena::Block vertex_block{};
+	GfxGeometryArena::Block index_block{};
 
 	std::uint32_t vertices{};
 	std::uint32_t indices{};
+	// 16 bit when every vertex is addressable by one
+	vk::IndexType index_type{vk::IndexType::eUint32};
+	VertexFormat vertex_format{};
+	// distance of the furthest vertex from the origin (for culling)
+	float radius{};
 };
 
 class GfxImage : public GfxAllocation {
@@ -84,6 +263,20 @@ class GfxImage : public GfxAllocation {
 	VulkanImage image{};
 };
 
+class GfxInstanceBuffer : public GfxBuffer<1> {
+  public:
+	using GfxBuffer::GfxBuffer;
+
+	std::uint32_t count{};
+};
+
+class GfxIndirectBuffer : public GfxBuffer<2> {
+  public:
+	using GfxBuffer::GfxBuffer;
+
+	std::vector<vk::DrawIndexedIndirectCommand> commands{};
+};
+
 class GfxShader : public GfxAllocation {
   public:
 	GfxShader(GfxDevice const* device) : GfxAllocation(device, Type::eShader) {}
@@ -71,7 +71,7 @@ struct VmaBuffer : VmaResource<vk::Buffer> {
 	std::size_t size{};
 	void* map{};
 
-	bool write(void const* data, std::size_t size);
+	bool write(void const* data, std::size_t size, std::size_t offset = 0);
 
 	struct Deleter {
 		void operator()(VmaBuffer const&) const;
@@ -97,6 +97,7 @@ using UniqueImage = Unique<VmaImage, VmaImage::Deleter>;
 using UniqueBuffer = Unique<VmaBuffer, VmaBuffer::Deleter>;
 
 struct CommandPoolFactory;
+class StagedUploads;
 using CommandFactory = Pool<CommandPool, CommandPoolFactory>;
 
 struct GfxDevice {
@@ -106,6 +107,7 @@ struct GfxDevice {
 	std::size_t buffering{};
 	CommandFactory* command_factory{};
 	DeferQueue* defer{};
+	StagedUploads* uploads{};
 	ZOrder default_z_order{};
 
 	vk::PhysicalDeviceLimits const* device_limits{};
@@ -116,7 +118,7 @@ struct GfxDevice {
 	explicit operator bool() const { return command_factory && allocator; }
 
 	UniqueImage make_image(vk::ImageCreateInfo info, bool host, bool linear = false) const;
-	UniqueBuffer make_buffer(vk::BufferCreateInfo info, bool host) const;
+	UniqueBuffer make_buffer(vk::BufferCreateInfo info, bool host, bool readback = false) const;
 	vk::SamplerCreateInfo sampler_info(vk::SamplerAddressMode mode, vk::Filter filter) const;
 
 	struct Deleter {
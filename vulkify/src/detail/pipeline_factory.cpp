@@ -1,19 +1,195 @@
+#include <detail/gfx_allocations.hpp>
 #include <detail/pipeline_factory.hpp>
 #include <detail/trace.hpp>
 #include <ktl/fixed_vector.hpp>
 #include <spir_v/default.frag.hpp>
 #include <spir_v/default.vert.hpp>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 
 namespace vf {
 namespace {
+constexpr vk::PolygonMode polygon_mode(PolygonMode mode) {
+	switch (mode) {
+	case PolygonMode::ePoint: return vk::PolygonMode::ePoint;
+	case PolygonMode::eLine: return vk::PolygonMode::eLine;
+	case PolygonMode::eFill:
+	default: return vk::PolygonMode::eFill;
+	}
+}
+
+constexpr vk::PrimitiveTopology topology(Topology topo) {
+	switch (topo) {
+	case Topology::eLineStrip: return vk::PrimitiveTopology::eLineStrip;
+	case Topology::eLineList: return vk::PrimitiveTopology::eLineList;
+	case Topology::ePointList: return vk::PrimitiveTopology::ePointList;
+	case Topology::eTriangleList: return vk::PrimitiveTopology::eTriangleList;
+	case Topology::eTriangleStrip:
+	default: return vk::PrimitiveTopology::eTriangleStrip;
+	}
+}
+
+// dynamic topology must be of the same class as the pipeline's
+constexpr vk::PrimitiveTopology topology_class(vk::PrimitiveTopology topo) {
+	switch (topo) {
+	case vk::PrimitiveTopology::ePointList: return vk::PrimitiveTopology::ePointList;
+	case vk::PrimitiveTopology::eLineList:
+	case vk::PrimitiveTopology::eLineStrip: return vk::PrimitiveTopology::eLineList;
+	default: return vk::PrimitiveTopology::eTriangleList;
+	}
+}
+
 bool make_default_shaders(vk::Device device, vk::UniqueShaderModule& vert, vk::UniqueShaderModule& frag) {
 	vert = device.createShaderModuleUnique({{}, std::size(default_vert_v), reinterpret_cast<std::uint32_t const*>(default_vert_v)});
 	frag = device.createShaderModuleUnique({{}, std::size(default_frag_v), reinterpret_cast<std::uint32_t const*>(default_frag_v)});
 	return vert && frag;
 }
+
+///
+/// \brief Prefixed to pipeline cache files: data is only loaded on the same GPU and driver version it was saved from
+///
+struct CacheHeader {
+	static constexpr std::uint32_t magic_v = 0x63706676; // "vfpc"
+	static constexpr std::uint32_t version_v = 1;
+
+	std::uint32_t magic{magic_v};
+	std::uint32_t version{version_v};
+	std::uint32_t vendor_id{};
+	std::uint32_t device_id{};
+	std::uint32_t driver_version{};
+	std::uint8_t uuid[VK_UUID_SIZE]{};
+	std::uint64_t size{};
+
+	static CacheHeader make(vk::PhysicalDeviceProperties const& props, std::uint64_t size) {
+		auto ret = CacheHeader{};
+		ret.vendor_id = props.vendorID;
+		ret.device_id = props.deviceID;
+		ret.driver_version = props.driverVersion;
+		std::memcpy(ret.uuid, props.pipelineCacheUUID.data(), sizeof(ret.uuid));
+		ret.size = size;
+		return ret;
+	}
+
+	bool matches(CacheHeader const& rhs) const {
+		return magic == rhs.magic && version == rhs.version && vendor_id == rhs.vendor_id && device_id == rhs.device_id &&
+			   driver_version == rhs.driver_version && std::memcmp(uuid, rhs.uuid, sizeof(uuid)) == 0;
+	}
+};
+
+///
+/// \brief Storage for all state referenced by a GraphicsPipelineCreateInfo (not movable once filled)
+///
+struct PipelineState {
+	vk::PipelineVertexInputStateCreateInfo pvisci{};
+	std::array<vk::PipelineShaderStageCreateInfo, 2> psscis{};
+	vk::PipelineInputAssemblyStateCreateInfo piasci{};
+	vk::PipelineRasterizationStateCreateInfo prsci{};
+	vk::PipelineDepthStencilStateCreateInfo pdssci{};
+	vk::PipelineColorBlendAttachmentState pcbas{};
+	vk::PipelineColorBlendStateCreateInfo pcbsci{};
+	vk::PipelineDynamicStateCreateInfo pdsci{};
+	ktl::fixed_vector<vk::DynamicState, 8> dynamic_states{};
+	vk::PipelineViewportStateCreateInfo pvsci{};
+	vk::PipelineMultisampleStateCreateInfo pmssci{};
+
+	PipelineState() = default;
+	PipelineState(PipelineState&&) = delete;
+	PipelineState& operator=(PipelineState&&) = delete;
+
+	vk::GraphicsPipelineCreateInfo fill(PipelineFactory const& factory, vk::PipelineLayout layout, PipelineFactory::Spec const& spec, vk::RenderPass render_pass) {
+		auto gpci = vk::GraphicsPipelineCreateInfo{};
+		gpci.renderPass = render_pass;
+		gpci.layout = layout;
+
+		auto const& vertex_input = factory.vertex_input[static_cast<std::size_t>(spec.vertex_format)];
+		pvisci.pVertexBindingDescriptions = vertex_input.bindings.data();
+		pvisci.vertexBindingDescriptionCount = static_cast<std::uint32_t>(vertex_input.bindings.size());
+		pvisci.pVertexAttributeDescriptions = vertex_input.attributes.data();
+		pvisci.vertexAttributeDescriptionCount = static_cast<std::uint32_t>(vertex_input.attributes.size());
+		gpci.pVertexInputState = &pvisci;
+
+		psscis[0] = vk::PipelineShaderStageCreateInfo({}, vk::ShaderStageFlagBits::eVertex, spec.shader.vert, "main");
+		psscis[1] = vk::PipelineShaderStageCreateInfo({}, vk::ShaderStageFlagBits::eFragment, spec.shader.frag, "main");
+		gpci.stageCount = static_cast<std::uint32_t>(psscis.size());
+		gpci.pStages = psscis.data();
+
+		piasci = vk::PipelineInputAssemblyStateCreateInfo({}, spec.topology);
+		gpci.pInputAssemblyState = &piasci;
+
+		prsci.polygonMode = spec.mode;
+		prsci.cullMode = vk::CullModeFlagBits::eNone;
+		gpci.pRasterizationState = &prsci;
+
+		pdssci.depthTestEnable = pdssci.depthWriteEnable = spec.depth_test;
+		pdssci.depthCompareOp = vk::CompareOp::eLess;
+		gpci.pDepthStencilState = &pdssci;
+
+		using CCF = vk::ColorComponentFlagBits;
+		pcbas.colorWriteMask = CCF::eR | CCF::eG | CCF::eB | CCF::eA;
+		pcbas.blendEnable = !spec.opaque;
+		pcbas.srcColorBlendFactor = vk::BlendFactor::eSrcAlpha;
+		pcbas.dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
+		pcbas.colorBlendOp = vk::BlendOp::eAdd;
+		pcbas.srcAlphaBlendFactor = vk::BlendFactor::eOne;
+		pcbas.dstAlphaBlendFactor = vk::BlendFactor::eZero;
+		pcbas.alphaBlendOp = vk::BlendOp::eAdd;
+		pcbsci.attachmentCount = 1;
+		pcbsci.pAttachments = &pcbas;
+		gpci.pColorBlendState = &pcbsci;
+
+		dynamic_states.clear();
+		dynamic_states.push_back(vk::DynamicState::eViewport);
+		dynamic_states.push_back(vk::DynamicState::eScissor);
+		dynamic_states.push_back(vk::DynamicState::eLineWidth);
+		if (factory.dynamic_state) {
+			dynamic_states.push_back(vk::DynamicState::ePrimitiveTopologyEXT);
+			dynamic_states.push_back(vk::DynamicState::eDepthTestEnableEXT);
+			dynamic_states.push_back(vk::DynamicState::eDepthWriteEnableEXT);
+		}
+		pdsci = vk::PipelineDynamicStateCreateInfo({}, static_cast<std::uint32_t>(dynamic_states.size()), dynamic_states.data());
+		gpci.pDynamicState = &pdsci;
+
+		pvsci = vk::PipelineViewportStateCreateInfo({}, 1, {}, 1);
+		gpci.pViewportState = &pvsci;
+
+		pmssci.rasterizationSamples = factory.samples;
+		pmssci.sampleShadingEnable = factory.sample_rate_shading;
+		gpci.pMultisampleState = &pmssci;
+
+		return gpci;
+	}
+};
+
+std::vector<char> load_cache_data(std::string const& path, vk::PhysicalDeviceProperties const& props) {
+	auto file = std::ifstream(path, std::ios::binary);
+	if (!file) { return {}; }
+	auto header = CacheHeader{};
+	if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) { return {}; }
+	if (!header.matches(CacheHeader::make(props, header.size))) {
+		VF_TRACEW("vf::(internal)", "Ignoring pipeline cache [{}] from a different GPU / driver", path);
+		return {};
+	}
+	// validate the stored size against the file before allocating: the header may be corrupt
+	auto const begin = static_cast<std::streamoff>(file.tellg());
+	file.seekg(0, std::ios::end);
+	auto const end = static_cast<std::streamoff>(file.tellg());
+	if (begin < 0 || end < begin || header.size > static_cast<std::uint64_t>(end - begin)) {
+		VF_TRACEW("vf::(internal)", "Ignoring truncated pipeline cache [{}]", path);
+		return {};
+	}
+	file.seekg(begin);
+	auto ret = std::vector<char>(static_cast<std::size_t>(header.size));
+	if (!file.read(ret.data(), static_cast<std::streamsize>(ret.size()))) {
+		VF_TRACEW("vf::(internal)", "Ignoring truncated pipeline cache [{}]", path);
+		return {};
+	}
+	return ret;
+}
 } // namespace
 
-PipelineFactory PipelineFactory::make(VulkanDevice const& device, VertexInput vertex_input, SetLayouts set_layouts, vk::SampleCountFlagBits samples, bool srr) {
+PipelineFactory PipelineFactory::make(VulkanDevice const& device, VertexInputs vertex_input, SetLayouts set_layouts, vk::SampleCountFlagBits samples, bool srr,
+									  std::string cache_path) {
 	if (!device) { return {}; }
 	auto ret = PipelineFactory{};
 	if (!make_default_shaders(device.device, ret.default_shaders.vert, ret.default_shaders.frag)) {
@@ -21,37 +197,111 @@ PipelineFactory PipelineFactory::make(VulkanDevice const& device, VertexInput ve
 		return {};
 	}
 	ret.device = device.device;
+	ret.gpu = device.gpu;
 	ret.vertex_input = std::move(vertex_input);
 	ret.set_layouts = std::move(set_layouts);
-	auto const limits = device.gpu.getProperties().limits;
-	ret.line_width_limit = {limits.lineWidthRange[0], limits.lineWidthRange[1]};
+	auto const props = device.gpu.getProperties();
+	ret.line_width_limit = {props.limits.lineWidthRange[0], props.limits.lineWidthRange[1]};
 	ret.samples = samples;
 	ret.sample_rate_shading = srr;
+	ret.dynamic_state = device.flags.test(VulkanDevice::Flag::eDynamicState);
+	auto const data = cache_path.empty() ? std::vector<char>{} : load_cache_data(cache_path, props);
+	ret.cache = device.device.createPipelineCacheUnique({{}, data.size(), data.data()});
+	if (!data.empty()) { VF_TRACEI("vf::(internal)", "Loaded pipeline cache [{}] ({} bytes)", cache_path, data.size()); }
+	ret.cache_path = std::move(cache_path);
 	return ret;
 }
 
+bool PipelineFactory::save_cache() const {
+	if (!device || !cache || cache_path.empty()) { return false; }
+	auto data = std::vector<std::uint8_t>{};
+	try {
+		data = device.getPipelineCacheData(*cache);
+	} catch ([[maybe_unused]] std::runtime_error const& e) {
+		VF_TRACEW("vf::(internal)", "Failed to get pipeline cache data! {}", e.what());
+		return false;
+	}
+	if (data.empty()) { return false; }
+	auto const header = CacheHeader::make(gpu.getProperties(), data.size());
+	// write to a temporary file first: an interrupted save must not leave a truncated cache behind
+	auto const temp = cache_path + ".tmp";
+	{
+		auto file = std::ofstream(temp, std::ios::binary | std::ios::trunc);
+		if (!file || !file.write(reinterpret_cast<char const*>(&header), sizeof(header)) ||
+			!file.write(reinterpret_cast<char const*>(data.data()), static_cast<std::streamsize>(data.size()))) {
+			VF_TRACEW("vf::(internal)", "Failed to write pipeline cache [{}]", temp);
+			return false;
+		}
+	}
+	auto ec = std::error_code{};
+	std::filesystem::rename(temp, cache_path, ec);
+	if (ec) {
+		VF_TRACEW("vf::(internal)", "Failed to save pipeline cache [{}]: {}", cache_path, ec.message());
+		return false;
+	}
+	VF_TRACEI("vf::(internal)", "Saved pipeline cache [{}] ({} bytes)", cache_path, data.size());
+	return true;
+}
+
+PipelineFactory::Spec PipelineFactory::Spec::make(RenderState const& state, Handle<Shader> shader, ZOrder default_z_order, VertexFormat vertex_format) {
+	auto program = Spec::ShaderProgram{};
+	if (shader && shader.allocation) {
+		assert(shader.allocation->type() == GfxAllocation::Type::eShader);
+		program.frag = *static_cast<GfxShader const*>(shader.allocation)->module;
+	}
+	return Spec{
+		.shader = program,
+		.mode = polygon_mode(state.polygon_mode),
+		.topology = topology(state.topology),
+		.depth_test = state.force_z_order.value_or(default_z_order) == ZOrder::eOn,
+		.vertex_format = vertex_format,
+		.opaque = state.opaque,
+	};
+}
+
+std::size_t PipelineFactory::Spec::hash() const {
+	auto ret = std::hash<vk::ShaderModule>{}(shader.vert);
+	ret = ret * 31 + std::hash<vk::ShaderModule>{}(shader.frag);
+	ret = ret * 31 + static_cast<std::size_t>(mode);
+	ret = ret * 31 + static_cast<std::size_t>(topology);
+	ret = ret * 31 + static_cast<std::size_t>(depth_test);
+	ret = ret * 31 + static_cast<std::size_t>(vertex_format);
+	return ret * 31 + static_cast<std::size_t>(opaque);
+}
+
 PipelineFactory::Entry* PipelineFactory::find(Spec const& spec) {
-	auto const it = std::find_if(entries.begin(), entries.end(), [&spec](Entry const& e) { return e.spec == spec; });
-	return it == entries.end() ? nullptr : &*it;
+	auto const it = entries.find(spec);
+	return it == entries.end() ? nullptr : &it->second;
 }
 
 PipelineFactory::Entry* PipelineFactory::get_or_load(Spec const& spec) {
 	if (auto ret = find(spec)) { return ret; }
 	if (!device) { return {}; }
-	Entry entry{spec};
+	Entry entry{};
 	entry.layout = device.createPipelineLayoutUnique({{}, static_cast<std::uint32_t>(set_layouts.size()), set_layouts.data()});
-	entries.push_back(std::move(entry));
-	return &entries.back();
+	auto [it, _] = entries.insert_or_assign(spec, std::move(entry));
+	return &it->second;
 }
 
 vk::PipelineLayout PipelineFactory::layout(Spec const& spec) {
+	auto lock = std::scoped_lock(*mutex);
 	if (auto entry = get_or_load(spec)) { return *entry->layout; }
 	return {};
 }
 
-std::pair<vk::Pipeline, vk::PipelineLayout> PipelineFactory::pipeline(Spec spec, vk::RenderPass render_pass) {
+PipelineFactory::Spec PipelineFactory::resolve(Spec spec) const {
 	if (!spec.shader.vert) { spec.shader.vert = *default_shaders.vert; }
 	if (!spec.shader.frag) { spec.shader.frag = *default_shaders.frag; }
+	if (dynamic_state) {
+		spec.topology = topology_class(spec.topology);
+		spec.depth_test = false;
+	}
+	return spec;
+}
+
+std::pair<vk::Pipeline, vk::PipelineLayout> PipelineFactory::pipeline(Spec spec, vk::RenderPass render_pass) {
+	spec = resolve(spec);
+	auto lock = std::scoped_lock(*mutex);
 	auto entry = get_or_load(spec);
 	if (!entry) { return {}; }
 	auto it = entry->pipelines.find(render_pass);
@@ -62,67 +312,52 @@ std::pair<vk::Pipeline, vk::PipelineLayout> PipelineFactory::pipeline(Spec spec,
 	return {*i->second, *entry->layout};
 }
 
-vk::UniquePipeline PipelineFactory::make_pipeline(vk::PipelineLayout layout, Spec spec, vk::RenderPass render_pass) const {
-	auto gpci = vk::GraphicsPipelineCreateInfo{};
-	gpci.renderPass = render_pass;
-	gpci.layout = layout;
-
-	auto pvisci = vk::PipelineVertexInputStateCreateInfo{};
-	pvisci.pVertexBindingDescriptions = vertex_input.bindings.data();
-	pvisci.vertexBindingDescriptionCount = static_cast<std::uint32_t>(vertex_input.bindings.size());
-	pvisci.pVertexAttributeDescriptions = vertex_input.attributes.data();
-	pvisci.vertexAttributeDescriptionCount = static_cast<std::uint32_t>(vertex_input.attributes.size());
-	gpci.pVertexInputState = &pvisci;
-
-	auto pssciVert = vk::PipelineShaderStageCreateInfo({}, vk::ShaderStageFlagBits::eVertex, spec.shader.vert, "main");
-	auto pssciFrag = vk::PipelineShaderStageCreateInfo({}, vk::ShaderStageFlagBits::eFragment, spec.shader.frag, "main");
-	auto psscis = std::array<vk::PipelineShaderStageCreateInfo, 2>{{pssciVert, pssciFrag}};
-	gpci.stageCount = static_cast<std::uint32_t>(psscis.size());
-	gpci.pStages = psscis.data();
-
-	auto piasci = vk::PipelineInputAssemblyStateCreateInfo({}, spec.topology);
-	gpci.pInputAssemblyState = &piasci;
-
-	auto prsci = vk::PipelineRasterizationStateCreateInfo();
-	prsci.polygonMode = spec.mode;
-	prsci.cullMode = vk::CullModeFlagBits::eNone;
-	gpci.pRasterizationState = &prsci;
-
-	auto pdssci = vk::PipelineDepthStencilStateCreateInfo{};
-	pdssci.depthTestEnable = pdssci.depthWriteEnable = spec.depth_test;
-	pdssci.depthCompareOp = vk::CompareOp::eLess;
-	gpci.pDepthStencilState = &pdssci;
-
-	auto pcbas = vk::PipelineColorBlendAttachmentState{};
-	using CCF = vk::ColorComponentFlagBits;
-	pcbas.colorWriteMask = CCF::eR | CCF::eG | CCF::eB | CCF::eA;
-	pcbas.blendEnable = true;
-	pcbas.srcColorBlendFactor = vk::BlendFactor::eSrcAlpha;
-	pcbas.dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
-	pcbas.colorBlendOp = vk::BlendOp::eAdd;
-	pcbas.srcAlphaBlendFactor = vk::BlendFactor::eOne;
-	pcbas.dstAlphaBlendFactor = vk::BlendFactor::eZero;
-	pcbas.alphaBlendOp = vk::BlendOp::eAdd;
-	auto pcbsci = vk::PipelineColorBlendStateCreateInfo();
-	pcbsci.attachmentCount = 1;
-	pcbsci.pAttachments = &pcbas;
-	gpci.pColorBlendState = &pcbsci;
-
-	auto pdsci = vk::PipelineDynamicStateCreateInfo();
-	vk::DynamicState const pdscis[] = {vk::DynamicState::eViewport, vk::DynamicState::eScissor, vk::DynamicState::eLineWidth};
-	pdsci = vk::PipelineDynamicStateCreateInfo({}, static_cast<std::uint32_t>(std::size(pdscis)), pdscis);
-	gpci.pDynamicState = &pdsci;
-
-	auto pvsci = vk::PipelineViewportStateCreateInfo({}, 1, {}, 1);
-	gpci.pViewportState = &pvsci;
-
-	auto pmssci = vk::PipelineMultisampleStateCreateInfo{};
-	pmssci.rasterizationSamples = samples;
-	pmssci.sampleShadingEnable = sample_rate_shading;
-	gpci.pMultisampleState = &pmssci;
+std::size_t PipelineFactory::prewarm(std::span<Spec const> specs, vk::RenderPass render_pass) {
+	if (!device || !render_pass) { return 0; }
+	auto pending = std::vector<std::pair<Spec, vk::PipelineLayout>>{};
+	{
+		auto lock = std::scoped_lock(*mutex);
+		for (auto spec : specs) {
+			spec = resolve(spec);
+			auto const* entry = get_or_load(spec);
+			if (!entry || entry->pipelines.find(render_pass) != entry->pipelines.end()) { continue; }
+			auto const queued = [&spec](auto const& p) { return p.first == spec; };
+			if (std::find_if(pending.begin(), pending.end(), queued) != pending.end()) { continue; }
+			pending.emplace_back(spec, *entry->layout);
+		}
+	}
+	if (pending.empty()) { return 0; }
+
+	// compile all pipelines in a single call, without holding the lock
+	auto states = std::vector<PipelineState>(pending.size());
+	auto gpcis = std::vector<vk::GraphicsPipelineCreateInfo>{};
+	gpcis.reserve(pending.size());
+	for (std::size_t i = 0; i < pending.size(); ++i) { gpcis.push_back(states[i].fill(*this, pending[i].second, pending[i].first, render_pass)); }
+	auto pipelines = std::vector<vk::UniquePipeline>{};
+	try {
+		pipelines = device.createGraphicsPipelinesUnique(cache ? *cache : vk::PipelineCache{}, gpcis).value;
+	} catch ([[maybe_unused]] std::runtime_error const& e) {
+		VF_TRACEW("vf::(internal)", "Pipeline prewarm failure! {}", e.what());
+		return 0;
+	}
+
+	auto ret = std::size_t{};
+	auto lock = std::scoped_lock(*mutex);
+	for (std::size_t i = 0; i < pipelines.size() && i < pending.size(); ++i) {
+		auto* entry = find(pending[i].first);
+		// may have been created on the render thread in the meantime
+		if (!entry || !pipelines[i] || entry->pipelines.find(render_pass) != entry->pipelines.end()) { continue; }
+		entry->pipelines.insert_or_assign(render_pass, std::move(pipelines[i]));
+		++ret;
+	}
+	return ret;
+}
 
+vk::UniquePipeline PipelineFactory::make_pipeline(vk::PipelineLayout layout, Spec spec, vk::RenderPass render_pass) const {
+	auto state = PipelineState{};
+	auto const gpci = state.fill(*this, layout, spec, render_pass);
 	try {
-		return device.createGraphicsPipelineUnique({}, gpci).value;
+		return device.createGraphicsPipelineUnique(cache ? *cache : vk::PipelineCache{}, gpci).value;
 	} catch ([[maybe_unused]] std::runtime_error const& e) {
 		VF_TRACEW("vf::(internal)", "Pipeline creation failure! {}", e.what());
 		return {};
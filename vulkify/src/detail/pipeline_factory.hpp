@@ -1,15 +1,27 @@
 #pragma once
 #include <detail/vulkan_device.hpp>
 #include <ktl/hash_table.hpp>
+#include <ktl/kunique_ptr.hpp>
 #include <vulkan/vulkan_hash.hpp>
+#include <vulkify/graphics/geometry.hpp>
+#include <vulkify/graphics/handle.hpp>
+#include <vulkify/graphics/render_state.hpp>
+#include <array>
+#include <mutex>
 #include <span>
+#include <string>
 
 namespace vf {
+class Shader;
+
 struct VertexInput {
 	std::span<vk::VertexInputBindingDescription const> bindings{};
 	std::span<vk::VertexInputAttributeDescription const> attributes{};
 };
 
+// indexed by VertexFormat
+using VertexInputs = std::array<VertexInput, 3>;
+
 struct VulkanPipeline {
 	vk::Pipeline pipeline{};
 	vk::PipelineLayout layout{};
@@ -24,44 +36,76 @@ struct PipelineFactory {
 			bool operator==(ShaderProgram const&) const = default;
 		};
 
+		struct Hasher {
+			std::size_t operator()(Spec const& spec) const { return spec.hash(); }
+		};
+
 		ShaderProgram shader{};
 		vk::PolygonMode mode{vk::PolygonMode::eFill};
 		vk::PrimitiveTopology topology{vk::PrimitiveTopology::eTriangleList};
 		bool depth_test{};
+		VertexFormat vertex_format{};
+		// blending disabled
+		bool opaque{};
+
+		static Spec make(RenderState const& state, Handle<Shader> shader, ZOrder default_z_order, VertexFormat vertex_format = {});
+
+		std::size_t hash() const;
 
 		bool operator==(Spec const&) const = default;
 	};
 
 	struct Entry {
-		Spec spec{};
 		vk::UniquePipelineLayout layout{};
 		ktl::hash_table<vk::RenderPass, vk::UniquePipeline> pipelines{};
 	};
 	using SetLayouts = std::vector<vk::DescriptorSetLayout>;
 
 	vk::Device device{};
-	VertexInput vertex_input{};
+	vk::PhysicalDevice gpu{};
+	VertexInputs vertex_input{};
 	SetLayouts set_layouts{};
 	vk::SampleCountFlagBits samples{};
 	bool sample_rate_shading{};
+	// topology (within its class) and depth test / write are set dynamically (VK_EXT_extended_dynamic_state)
+	bool dynamic_state{};
 
-	std::vector<Entry> entries{};
+	ktl::hash_table<Spec, Entry, Spec::Hasher> entries{};
 	struct {
 		vk::UniqueShaderModule vert{};
 		vk::UniqueShaderModule frag{};
 	} default_shaders{};
 	std::pair<float, float> line_width_limit{1.0f, 1.0f};
+	vk::UniquePipelineCache cache{};
+	std::string cache_path{};
+	// guards entries: pipelines may be prewarmed on another thread
+	ktl::kunique_ptr<std::mutex> mutex{ktl::make_unique<std::mutex>()};
 
-	static PipelineFactory make(VulkanDevice const& device, VertexInput vertexInput, SetLayouts setLayouts, vk::SampleCountFlagBits samples, bool srr);
+	static PipelineFactory make(VulkanDevice const& device, VertexInputs vertexInput, SetLayouts setLayouts, vk::SampleCountFlagBits samples, bool srr,
+								std::string cachePath = {});
 
 	explicit operator bool() const { return device; }
 
 	Entry* find(Spec const& spec);
 	Entry* get_or_load(Spec const& spec);
 
+	///
+	/// \brief Fill in default shaders and reset state that is set dynamically: specs differing only in such state share a pipeline
+	///
+	Spec resolve(Spec spec) const;
 	std::pair<vk::Pipeline, vk::PipelineLayout> pipeline(Spec spec, vk::RenderPass renderPass);
+	///
+	/// \brief Create all missing pipelines for specs in a single call (only locks mutex to access entries)
+	/// \returns Number of pipelines created
+	///
+	std::size_t prewarm(std::span<Spec const> specs, vk::RenderPass renderPass);
 	vk::PipelineLayout layout(Spec const& spec);
 
+	///
+	/// \brief Write cache contents to cache_path (if set)
+	///
+	bool save_cache() const;
+
 	vk::UniquePipelineLayout make_layout() const;
 	vk::UniquePipeline make_pipeline(vk::PipelineLayout layout, Spec spec, vk::RenderPass renderPass) const;
 };
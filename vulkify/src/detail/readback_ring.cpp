@@ -0,0 +1,100 @@
+#include <detail/readback_ring.hpp>
+#include <detail/trace.hpp>
+#include <utility>
+
+namespace vf {
+namespace {
+std::optional<Readback::Order> pixel_order(vk::Format const format) {
+	switch (format) {
+	case vk::Format::eR8G8B8A8Srgb:
+	case vk::Format::eR8G8B8A8Unorm: return Readback::Order::eRgba;
+	case vk::Format::eB8G8R8A8Srgb:
+	case vk::Format::eB8G8R8A8Unorm: return Readback::Order::eBgra;
+	default: return {};
+	}
+}
+} // namespace
+
+ReadbackRing ReadbackRing::make(GfxDevice const* device, vk::Format const format) {
+	if (!device || !*device) { return {}; }
+	auto const order = pixel_order(format);
+	if (!order) {
+		VF_TRACEW("vf::(internal)", "Unsupported colour format for readback: [{}]", static_cast<int>(format));
+		return {};
+	}
+	auto ret = ReadbackRing{};
+	ret.m_device = device;
+	for (auto& slot : ret.m_slots) { slot.fence = device->device.device.createFenceUnique({vk::FenceCreateFlagBits::eSignaled}); }
+	ret.m_order = *order;
+	return ret;
+}
+
+bool ReadbackRing::request() {
+	if (!m_device) { return false; }
+	if (m_count >= capacity_v) {
+		VF_TRACEW("vf::(internal)", "Readback ring full, dropping capture of frame [{}]", m_frame);
+		return false;
+	}
+	m_requested = true;
+	return true;
+}
+
+bool ReadbackRing::record(vk::CommandBuffer const cb, ImageView const& image) {
+	if (!m_requested) { return false; }
+	m_requested = false;
+	if (!m_device || m_count >= capacity_v || !image.image) { return false; }
+
+	auto& slot = at(m_count);
+	auto const extent = Extent{image.extent.width, image.extent.height};
+	auto const size = Image::size_bytes(extent);
+	if (!slot.buffer || slot.buffer->size < size) {
+		auto const bci = vk::BufferCreateInfo({}, size, vk::BufferUsageFlagBits::eTransferDst);
+		slot.buffer = m_device->make_buffer(bci, true, true);
+		if (!slot.buffer || !slot.buffer->map) { return false; }
+	}
+
+	auto const isl = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0U, 0U, 1U);
+	auto const bic = vk::BufferImageCopy({}, 0U, 0U, isl, {}, vk::Extent3D(image.extent, 1U));
+	cb.copyImageToBuffer(image.image, vk::ImageLayout::eTransferSrcOptimal, slot.buffer->resource, bic);
+	auto const bmb = vk::BufferMemoryBarrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eHostRead, VK_QUEUE_FAMILY_IGNORED,
+											 VK_QUEUE_FAMILY_IGNORED, slot.buffer->resource, 0U, size);
+	cb.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {}, {}, bmb, {});
+
+	slot.extent = extent;
+	slot.frame = m_frame;
+	m_recorded = true;
+	return true;
+}
+
+void ReadbackRing::submit() {
+	++m_frame;
+	if (!std::exchange(m_recorded, false)) { return; }
+	auto& slot = at(m_count);
+	// the slot is past the polled range: its previous fence (if any) has signalled and been consumed
+	m_device->device.reset(*slot.fence, {});
+	// an empty batch's fence signals once all previously submitted work (the frame) has completed
+	auto const si = vk::SubmitInfo{};
+	auto lock = std::scoped_lock(*m_device->device.queue_mutex);
+	auto const res = m_device->device.queue.queue.submit(1U, &si, *slot.fence);
+	if (res != vk::Result::eSuccess) {
+		VF_TRACE("vf::(internal)", trace::Type::eError, "Readback fence submit failure!");
+		return;
+	}
+	++m_count;
+}
+
+std::size_t ReadbackRing::poll(OnReadback const& callback) {
+	std::size_t ret{};
+	while (m_count > 0) {
+		auto& slot = at(0);
+		if (m_device->device.busy(*slot.fence)) { break; }
+		vmaInvalidateAllocation(slot.buffer->allocator, slot.buffer->handle, 0U, VK_WHOLE_SIZE);
+		auto const bytes = std::span<std::byte const>(static_cast<std::byte const*>(slot.buffer->map), Image::size_bytes(slot.extent));
+		if (callback) { callback(Readback{{bytes, slot.extent}, m_order, slot.frame}); }
+		m_head = (m_head + 1) % capacity_v;
+		--m_count;
+		++ret;
+	}
+	return ret;
+}
+} // namespace vf
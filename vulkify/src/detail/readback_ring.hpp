@@ -0,0 +1,48 @@
+#pragma once
+#include <detail/gfx_device.hpp>
+#include <vulkify/instance/readback.hpp>
+#include <optional>
+
+namespace vf {
+///
+/// \brief Ring of persistently mapped host buffers that rendered colour targets are copied into
+///
+/// Copies are recorded into the frame's command buffer and fenced by an empty submit right after it;
+/// poll() only delivers slots whose fences have signalled, so the CPU never waits on an in-flight frame.
+/// Requests made while every slot is in flight are dropped.
+///
+class ReadbackRing {
+  public:
+	static constexpr std::size_t capacity_v = 4;
+
+	static ReadbackRing make(GfxDevice const* device, vk::Format format);
+
+	explicit operator bool() const { return m_device != nullptr; }
+
+	bool request();
+	bool requested() const { return m_requested; }
+	bool record(vk::CommandBuffer cb, ImageView const& image);
+	void submit();
+	std::size_t poll(OnReadback const& callback);
+
+  private:
+	struct Slot {
+		UniqueBuffer buffer{};
+		// owned by the slot: only reset (and reused) once the slot has been consumed by poll()
+		vk::UniqueFence fence{};
+		Extent extent{};
+		std::uint64_t frame{};
+	};
+
+	Slot& at(std::size_t offset) { return m_slots[(m_head + offset) % capacity_v]; }
+
+	Slot m_slots[capacity_v]{};
+	GfxDevice const* m_device{};
+	std::size_t m_head{};
+	std::size_t m_count{};
+	std::uint64_t m_frame{};
+	Readback::Order m_order{};
+	bool m_requested{};
+	bool m_recorded{};
+};
+} // namespace vf
@@ -1,19 +1,26 @@
 #pragma once
 #include <detail/gfx_allocations.hpp>
+#include <detail/pipeline_factory.hpp>
 #include <detail/set_writer.hpp>
 #include <glm/vec2.hpp>
 #include <ktl/unique_val.hpp>
 #include <vulkify/graphics/camera.hpp>
+#include <vulkify/graphics/detail/draw_model.hpp>
 #include <vulkify/graphics/handle.hpp>
+#include <vulkify/graphics/render_stats.hpp>
 #include <mutex>
+#include <optional>
+#include <vector>
 
 namespace vf {
 class Instance;
 class Texture;
-struct DrawModel;
-struct PipelineFactory;
+class GeometryBuffer;
+class IndirectBuffer;
+class InstanceBuffer;
 struct CombinedImageSampler;
 struct DescriptorSetFactory;
+struct RenderWorker;
 
 struct SetBind {
 	std::uint32_t set{};
@@ -29,8 +36,10 @@ struct ShaderInput {
 		vk::UniqueSampler sampler{};
 		ImageCache white{};
 		ImageCache magenta{};
+		// texture coordinates and colour of every VertexFormat::ePosition vertex
+		UniqueBuffer vertex{};
 
-		explicit operator bool() const { return sampler && white.image && magenta.image; }
+		explicit operator bool() const { return sampler && white.image && magenta.image && vertex; }
 	};
 
 	SetWriter mat_p{};
@@ -44,7 +53,120 @@ struct RenderCam {
 	Camera* camera{};
 };
 
+///
+/// \brief Camera state captured when a draw is submitted
+///
+struct DrawView {
+	DrawModel model{};
+	vk::Viewport viewport{};
+
+	bool operator==(DrawView const& rhs) const {
+		return model.pos_orn == rhs.model.pos_orn && model.scl_z_tint == rhs.model.scl_z_tint && viewport == rhs.viewport;
+	}
+};
+
+///
+/// \brief Draw submitted to a Surface, recorded into the command buffer at the end of the pass
+///
+struct DrawCommand {
+	struct Range {
+		std::size_t offset{};
+		std::size_t count{};
+	};
+
+	///
+	/// \brief Geometry buffer state captured when the draw is submitted
+	///
+	struct Geometry {
+		vk::Buffer vbo{};
+		vk::Buffer ibo{};
+		// ShaderInput::Textures::vertex bound to binding 1 (VertexFormat::ePosition)
+		bool vertex_defaults{};
+		std::uint32_t vertices{};
+		std::uint32_t indices{};
+		// non zero for sub-allocations of a GeometryArena
+		std::uint32_t first_vertex{};
+		std::uint32_t first_index{};
+		vk::IndexType index_type{vk::IndexType::eUint32};
+
+		bool operator==(Geometry const&) const = default;
+	};
+
+	///
+	/// \brief GPU resident instance / indirect buffer state captured when the draw is submitted
+	///
+	struct Resident {
+		UploadRing::Alloc models{};
+		vk::Buffer args{};
+		// instances in an InstanceBuffer / commands in an IndirectBuffer
+		std::uint32_t count{};
+		// indirect commands to record directly (in DrawList::indirect) if drawIndirectFirstInstance is unsupported
+		Range commands{};
+	};
+
+	std::uint64_t key{};
+	PipelineFactory::Spec spec{};
+	DrawView view{};
+	Handle<GeometryBuffer> buffer{};
+	Handle<Texture> texture{};
+	Handle<IndirectBuffer> indirect{};
+	Handle<InstanceBuffer> instances{};
+	Geometry geometry{};
+	Resident resident{};
+	Range models{};
+	float line_width{};
+	struct {
+		Range bytes{};
+		Handle<Texture> texture{};
+		bool active{};
+	} custom{};
+
+	bool batches_with(DrawCommand const& rhs) const;
+};
+
+///
+/// \brief Draws submitted during a pass, optionally sorted / batched before being recorded
+///
+/// Sort keys (msb to lsb): 16 bits pipeline spec hash, 24 bits texture, 24 bits depth (front to back).
+/// Only runs of consecutive opaque depth-tested draws are sorted: blended draws rely on submission order
+/// (the depth test would discard farther ones drawn after closer ones), and retain it.
+///
+struct DrawList {
+	std::vector<DrawCommand> commands{};
+	std::vector<DrawModel> models{};
+	std::vector<std::byte> bytes{};
+	std::vector<vk::DrawIndexedIndirectCommand> indirect{};
+	std::vector<DrawModel> scratch{};
+	std::vector<std::uint8_t> visible{};
+	bool sort{};
+	bool batch{};
+	bool cull{};
+
+	static std::uint64_t make_key(PipelineFactory::Spec const& spec, Handle<Texture> texture, float z);
+
+	///
+	/// \brief Whether draws with spec may be reordered (front to back) without changing the output
+	///
+	static constexpr bool sortable(PipelineFactory::Spec const& spec) { return spec.depth_test && spec.opaque; }
+
+	void sort_opaque();
+
+	void clear() {
+		commands.clear();
+		models.clear();
+		bytes.clear();
+		indirect.clear();
+	}
+};
+
 struct RenderPass {
+	struct BoundSet {
+		vk::DescriptorSet set{};
+		std::uint32_t dynamic_offset{};
+	};
+
+	static constexpr std::size_t max_sets_v = 3;
+
 	ktl::unique_val<Instance*> instance{};
 	GfxDevice const* device{};
 	PipelineFactory* pipeline_factory{};
@@ -55,15 +177,72 @@ struct RenderPass {
 	RenderCam cam{};
 	TPair<float> line_width_limit{};
 	std::mutex* render_mutex;
+	DrawList* draw_list{};
+	// guards state shared with other recording threads (pipeline factory, geometry buffers); null if render_mutex already does
+	std::mutex* shared_mutex{};
+	RenderWorker* worker{};
 
 	mutable vk::PipelineLayout bound{};
+	mutable BoundSet bound_sets[max_sets_v]{};
+	///
+	/// \brief Spec of the last pipeline bound; draws with the same RenderState skip the factory
+	///
+	mutable struct {
+		PipelineFactory::Spec spec{};
+		vk::Pipeline pipeline{};
+		vk::PipelineLayout layout{};
+	} last_pipeline{};
+	///
+	/// \brief Extended dynamic state last set (if supported)
+	///
+	mutable struct {
+		vk::PrimitiveTopology topology{};
+		bool depth_test{};
+		bool set{};
+	} dynamic_state{};
+	///
+	/// \brief Dynamic state and buffers last recorded: redundant commands are skipped
+	///
+	mutable struct {
+		std::optional<vk::Viewport> viewport{};
+		std::optional<float> line_width{};
+		vk::Buffer vbo{};
+		vk::Buffer ibo{};
+		vk::IndexType index_type{};
+	} bound_state{};
+	mutable RenderStats stats{};
+	///
+	/// \brief View UBO last written to the upload ring; reused until the camera changes
+	///
+	mutable struct {
+		DrawModel model{};
+		UploadRing::Alloc alloc{};
+	} view_ubo{};
 
 	CombinedImageSampler image_sampler(Handle<Texture> texture) const;
 	CombinedImageSampler white_texture() const;
-	void write_view(SetWriter& set) const;
-	void write_models(SetWriter& set, std::span<DrawModel const> instances, Handle<Texture> texture) const;
+	DrawView view() const;
+	void write_view(SetWriter& set, DrawModel const& view) const;
+	///
+	/// \brief Write instances to the upload ring and bind set (texture / buffer updates and the bind are skipped if unchanged)
+	/// \returns firstInstance of the draw
+	///
+	std::optional<std::uint32_t> write_models(SetWriter& set, std::span<DrawModel const> instances, CombinedImageSampler const& texture) const;
+	bool write_instances(SetWriter& set, UploadRing::Alloc const& instances, CombinedImageSampler const& texture) const;
 	void write_custom(SetWriter& set, std::span<std::byte const> ubo, Handle<Texture> texture) const;
 	void bind(vk::PipelineLayout layout, vk::Pipeline pipeline) const;
-	void set_viewport() const;
+	void bind_set(SetWriter const& set) const;
+	bool bind(PipelineFactory::Spec const& spec) const;
+	void set_dynamic_state(vk::PrimitiveTopology topology, bool depth_test) const;
+	void set_viewport(vk::Viewport const& viewport) const;
+	void set_line_width(float line_width) const;
+	void bind_vbo(vk::Buffer buffer, VertexFormat format) const;
+	void bind_ibo(vk::Buffer buffer, vk::IndexType type) const;
+
+	std::unique_lock<std::mutex> lock_shared() const { return shared_mutex ? std::unique_lock(*shared_mutex) : std::unique_lock<std::mutex>{}; }
+	///
+	/// \brief Lock the main pass mutex (from any recording thread, without holding it already)
+	///
+	std::unique_lock<std::mutex> lock_main() const { return std::unique_lock(shared_mutex ? *shared_mutex : *render_mutex); }
 };
 } // namespace vf
@@ -0,0 +1,84 @@
+#pragma once
+#include <detail/descriptor_set_factory.hpp>
+#include <detail/render_pass.hpp>
+#include <detail/renderer.hpp>
+#include <detail/rotator.hpp>
+#include <ktl/kunique_ptr.hpp>
+#include <vulkify/graphics/surface.hpp>
+#include <atomic>
+#include <mutex>
+
+namespace vf {
+///
+/// \brief Command buffers, descriptor sets, and draw list for a Surface recorded on another thread
+///
+/// Rotated every frame along with the main pass (used or not), so each buffered command buffer / descriptor pool
+/// is only reused after the frame that last used it has been waited on.
+///
+struct RenderWorker {
+	vk::UniqueCommandPool command_pool{};
+	Rotator<vk::CommandBuffer> command_buffers{};
+	DescriptorSetFactory set_factory{};
+	DrawList draw_list{};
+	RenderPass render_pass{};
+	// copied from main's in begin(): the main thread may modify its camera while this worker records
+	Camera camera{};
+	std::mutex mutex{};
+	std::atomic<bool> recording{};
+
+	static ktl::kunique_ptr<RenderWorker> make(GfxDevice const& device, std::span<vk::DescriptorSetLayout const> layouts) {
+		if (!device) { return {}; }
+		auto ret = ktl::make_unique<RenderWorker>();
+		static constexpr auto flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer | vk::CommandPoolCreateFlagBits::eTransient;
+		ret->command_pool = device.device.device.createCommandPoolUnique({flags, device.device.queue.family});
+		auto const count = static_cast<std::uint32_t>(device.buffering);
+		auto cmds = device.device.device.allocateCommandBuffers({*ret->command_pool, vk::CommandBufferLevel::eSecondary, count});
+		for (auto const cmd : cmds) { ret->command_buffers.push(cmd); }
+		ret->set_factory = DescriptorSetFactory::make(device, layouts);
+		if (!ret->set_factory) { return {}; }
+		return ret;
+	}
+
+	///
+	/// \brief Begin recording a secondary command buffer inheriting main's render pass and framebuffer
+	///
+	Surface begin(RenderPass const& main, Framebuffer const& framebuffer) {
+		auto const cmd = command_buffers.get();
+		auto const cbii = vk::CommandBufferInheritanceInfo(main.render_pass, 0U, framebuffer);
+		cmd.begin({vk::CommandBufferUsageFlagBits::eOneTimeSubmit | vk::CommandBufferUsageFlagBits::eRenderPassContinue, &cbii});
+		cmd.setScissor(0, vk::Rect2D({}, framebuffer.extent));
+
+		draw_list.clear();
+		if (main.draw_list) {
+			draw_list.sort = main.draw_list->sort;
+			draw_list.batch = main.draw_list->batch;
+			draw_list.cull = main.draw_list->cull;
+		}
+		auto const* device = main.device;
+		camera = main.cam.camera ? *main.cam.camera : Camera{};
+		auto const cam = RenderCam{main.cam.extent, &camera};
+		render_pass = RenderPass{main.instance.value, device, main.pipeline_factory, &set_factory, main.render_pass, cmd, main.shader_input, cam, main.line_width_limit, &mutex};
+		render_pass.draw_list = &draw_list;
+		// pipeline factory and geometry buffers are shared with the main pass and other workers
+		render_pass.shared_mutex = main.render_mutex;
+		render_pass.worker = this;
+		recording = true;
+		return Surface{&render_pass};
+	}
+
+	///
+	/// \brief End recording (if active)
+	/// \returns false if not recording
+	///
+	bool end() {
+		if (!recording.exchange(false)) { return false; }
+		render_pass.command_buffer.end();
+		return true;
+	}
+
+	void next() {
+		command_buffers.next();
+		set_factory.next();
+	}
+};
+} // namespace vf
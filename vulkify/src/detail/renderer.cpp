@@ -122,6 +122,20 @@ void Renderer::Frame::colour_to_present(ImageView const& image) const {
 	barrier(cmd, image.image, {vk::ImageLayout::eColorAttachmentOptimal, vk::ImageLayout::ePresentSrcKHR});
 }
 
+void Renderer::Frame::colour_to_readback(ImageView const& image) const {
+	auto barrier = ImageBarrier{};
+	barrier.access = {vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite, vk::AccessFlagBits::eTransferRead};
+	barrier.stages = {vk::PipelineStageFlagBits::eColorAttachmentOutput, vk::PipelineStageFlagBits::eTransfer};
+	barrier(cmd, image.image, {vk::ImageLayout::eColorAttachmentOptimal, vk::ImageLayout::eTransferSrcOptimal});
+}
+
+void Renderer::Frame::readback_to_present(ImageView const& image) const {
+	auto barrier = ImageBarrier{};
+	barrier.access = {vk::AccessFlagBits::eTransferRead, {}};
+	barrier.stages = {vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe};
+	barrier(cmd, image.image, {vk::ImageLayout::eTransferSrcOptimal, vk::ImageLayout::ePresentSrcKHR});
+}
+
 void Renderer::Frame::colour_to_tfr(ImageView const& src, ImageView const& dst) const {
 	auto barrier = ImageBarrier{};
 	barrier.access = {vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite,
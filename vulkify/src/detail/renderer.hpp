@@ -46,6 +46,8 @@ struct Renderer::Frame {
 	void undef_to_colour(std::span<ImageView const> images) const;
 	void colour_to_tfr(ImageView const& src, ImageView const& dst) const;
 	void colour_to_present(ImageView const& image) const;
+	void colour_to_readback(ImageView const& image) const;
+	void readback_to_present(ImageView const& image) const;
 	void tfr_to_present(ImageView const& image) const;
 };
 } // namespace vf
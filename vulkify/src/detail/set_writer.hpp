@@ -1,5 +1,7 @@
 #pragma once
 #include <detail/gfx_device.hpp>
+#include <detail/upload_ring.hpp>
+#include <optional>
 #include <span>
 
 namespace vf {
@@ -12,45 +14,104 @@ struct SetWriter {
 	};
 
 	static constexpr BufferLayout buffer_layouts_v[] = {
-		{vk::DescriptorType::eUniformBuffer, vk::BufferUsageFlagBits::eUniformBuffer},
+		{vk::DescriptorType::eUniformBufferDynamic, vk::BufferUsageFlagBits::eUniformBuffer},
 		{vk::DescriptorType::eStorageBuffer, vk::BufferUsageFlagBits::eStorageBuffer},
 	};
 
-	GfxDevice* device{};
+	///
+	/// \brief Last written contents of a descriptor set, used to skip redundant updates
+	///
+	/// Buffers and images are identified by allocation id rather than handle, as handles may be recycled.
+	///
+	struct State {
+		struct Buffer {
+			std::uint64_t id{};
+			vk::DeviceSize range{};
 
-	std::span<UniqueBuffer> buffers{};
+			bool operator==(Buffer const&) const = default;
+		};
+
+		Buffer buffers[eCOUNT_]{};
+		CombinedImageSampler image{};
+	};
+
+	GfxDevice const* device{};
+	UploadRing* ring{};
+	State* state{};
 	vk::DescriptorSet set{};
 	std::uint32_t number{};
+	std::uint32_t dynamic_offset{};
 
-	explicit operator bool() const { return device && *device && !buffers.empty() && set; }
-
-	void refresh(UniqueBuffer& out, std::size_t const size, vk::BufferUsageFlagBits const usage) const {
-		if (!out->resource || out->size != size) { out = device->make_buffer({{}, size, usage}, true); }
-	}
+	explicit operator bool() const { return device && *device && ring && state && set; }
 
+	///
+	/// \brief Copy data into the upload ring and point the (dynamic) uniform binding at it
+	///
 	bool write(std::uint32_t binding, void const* data, std::size_t size) {
-		assert(binding < eCOUNT_);
+		assert(binding == eUniform);
 		if (!static_cast<bool>(*this)) { return false; }
-		refresh(buffers[binding], size, buffer_layouts_v[binding].usage);
-		auto buf = buffers[binding].get();
-		auto const ret = buf.write(data, size);
-		auto dbi = vk::DescriptorBufferInfo(buf.resource, {}, size);
-		auto wds = vk::WriteDescriptorSet(set, binding, 0, 1, buffer_layouts_v[binding].type, {}, &dbi);
-		device->device.device.updateDescriptorSets(1, &wds, 0, {});
-		return ret;
+		return write(binding, ring->write(data, size, ring->ubo_alignment), size);
+	}
+
+	///
+	/// \brief Point the (dynamic) uniform binding at data previously written to the upload ring
+	///
+	bool write(std::uint32_t binding, UploadRing::Alloc const& alloc, std::size_t size) {
+		assert(binding == eUniform);
+		if (!static_cast<bool>(*this) || !alloc) { return false; }
+		update_buffer(binding, alloc, size);
+		dynamic_offset = static_cast<std::uint32_t>(alloc.offset);
+		return true;
 	}
 
-	bool update(std::uint32_t binding, vk::Sampler sampler, vk::ImageView view) {
-		if (!static_cast<bool>(*this) || !sampler || !view) { return false; }
-		auto dii = vk::DescriptorImageInfo(sampler, view, vk::ImageLayout::eShaderReadOnlyOptimal);
+	///
+	/// \brief Copy elements into the upload ring and point the storage binding at the whole ring buffer
+	/// \returns Index of the first element in the bound buffer (to be passed as firstInstance)
+	///
+	template <typename T>
+	std::optional<std::uint32_t> write_array(std::uint32_t binding, std::span<T const> elements) {
+		assert(binding == eStorage);
+		if (!static_cast<bool>(*this)) { return {}; }
+		auto const alloc = ring->write(elements.data(), elements.size_bytes(), sizeof(T));
+		if (!alloc) { return {}; }
+		update_buffer(binding, alloc, VK_WHOLE_SIZE);
+		return static_cast<std::uint32_t>(alloc.offset / sizeof(T));
+	}
+
+	///
+	/// \brief Point the storage binding at an externally owned buffer (whole size)
+	///
+	bool write_buffer(std::uint32_t binding, UploadRing::Alloc const& buffer) {
+		assert(binding == eStorage);
+		if (!static_cast<bool>(*this) || !buffer) { return false; }
+		update_buffer(binding, buffer, VK_WHOLE_SIZE);
+		return true;
+	}
+
+	bool update(std::uint32_t binding, CombinedImageSampler const& image) {
+		if (!static_cast<bool>(*this) || !image.sampler || !image.view) { return false; }
+		if (state->image == image) { return true; }
+		auto dii = vk::DescriptorImageInfo(image.sampler, image.view, vk::ImageLayout::eShaderReadOnlyOptimal);
 		auto wds = vk::WriteDescriptorSet(set, binding, 0, 1, vk::DescriptorType::eCombinedImageSampler, &dii);
 		device->device.device.updateDescriptorSets(1, &wds, 0, {});
+		state->image = image;
 		return true;
 	}
 
 	void bind(vk::CommandBuffer cmd, vk::PipelineLayout const layout) const {
 		if (!set || !cmd || !layout) { return; }
-		cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, layout, number, set, {});
+		cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, layout, number, set, dynamic_offset);
+	}
+
+  private:
+	void update_buffer(std::uint32_t binding, UploadRing::Alloc const& alloc, vk::DeviceSize range) {
+		auto& cached = state->buffers[binding];
+		auto const buffer = State::Buffer{alloc.id, range};
+		if (cached == buffer) { return; }
+		auto const dbi = vk::DescriptorBufferInfo(alloc.buffer, {}, range);
+		auto wds = vk::WriteDescriptorSet(set, binding, 0, 1, buffer_layouts_v[binding].type, {}, &dbi);
+		device->device.device.updateDescriptorSets(1, &wds, 0, {});
+		cached = buffer;
 	}
 };
 } // namespace vf
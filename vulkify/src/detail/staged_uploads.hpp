@@ -0,0 +1,32 @@
+#pragma once
+#include <ktl/kunique_ptr.hpp>
+#include <vulkan/vulkan.hpp>
+#include <mutex>
+#include <vector>
+
+namespace vf {
+struct BufferCache;
+
+///
+/// \brief Device local buffers with ranges pending upload, recorded into the next frame's command buffer
+///
+/// Buffers are queued when acquired for a draw, so ranges written across multiple calls / frames are
+/// coalesced and uploaded once, before the render pass of the frame that draws them: no CPU stall.
+/// Queued buffers must outlive the frame (GfxAllocations are destroyed via DeferQueue).
+///
+class StagedUploads {
+  public:
+	StagedUploads() : m_mutex(ktl::make_unique<std::mutex>()) {}
+
+	void push(BufferCache const* cache);
+	///
+	/// \brief Record transfers of all queued ranges into cb (outside a render pass)
+	///
+	void record(vk::CommandBuffer cb);
+	void clear();
+
+  private:
+	std::vector<BufferCache const*> m_caches{};
+	ktl::kunique_ptr<std::mutex> m_mutex{};
+};
+} // namespace vf
@@ -0,0 +1,87 @@
+#pragma once
+#include <detail/defer_queue.hpp>
+#include <detail/gfx_device.hpp>
+#include <detail/rotator.hpp>
+#include <bit>
+#include <cstring>
+
+namespace vf {
+///
+/// \brief Persistently mapped host buffer per frame-in-flight, sub-allocated linearly for descriptor data
+///
+/// Each frame bumps through its own buffer; next() rotates to the following frame's buffer and rewinds it.
+/// A full buffer is replaced by one twice as large (the old one is deferred, since earlier writes may still be bound).
+///
+struct UploadRing {
+	static constexpr vk::DeviceSize block_size_v = 64 * 1024;
+	static constexpr auto usage_v = vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eStorageBuffer;
+
+	struct Block {
+		UniqueBuffer buffer{};
+		vk::DeviceSize head{};
+	};
+
+	struct Alloc {
+		vk::Buffer buffer{};
+		vk::DeviceSize offset{};
+		std::uint64_t id{};
+
+		explicit operator bool() const { return static_cast<bool>(buffer); }
+	};
+
+	GfxDevice const* device{};
+	Rotator<Block, 4> blocks{};
+	vk::DeviceSize ubo_alignment{1};
+
+	static UploadRing make(GfxDevice const& device) {
+		auto ret = UploadRing{&device};
+		if (device.device_limits) { ret.ubo_alignment = std::max(device.device_limits->minUniformBufferOffsetAlignment, vk::DeviceSize{1}); }
+		for (std::size_t i = 0; i < device.buffering; ++i) { ret.blocks.push(Block{device.make_buffer({{}, block_size_v, usage_v}, true)}); }
+		return ret;
+	}
+
+	explicit operator bool() const { return device && !blocks.storage.empty(); }
+
+	///
+	/// \brief Ensure the current buffer has room for size more bytes (growing if necessary)
+	///
+	/// Callers that must not observe a buffer switch across several writes (eg a shared descriptor set) reserve first.
+	///
+	bool reserve(std::size_t const size) {
+		if (!*this) { return false; }
+		auto& block = blocks.get();
+		if (block.buffer && block.head + size <= block.buffer->size) { return true; }
+		return grow(block, size);
+	}
+
+	std::uint64_t buffer_id() const { return *this && blocks.get().buffer ? blocks.get().buffer->id : 0; }
+
+	Alloc write(void const* data, std::size_t const size, vk::DeviceSize const align) {
+		if (!*this || !data || size == 0) { return {}; }
+		auto& block = blocks.get();
+		auto offset = (block.head + align - 1) / align * align;
+		if (!block.buffer || offset + size > block.buffer->size) {
+			if (!grow(block, size)) { return {}; }
+			offset = 0;
+		}
+		std::memcpy(static_cast<std::byte*>(block.buffer->map) + offset, data, size);
+		block.head = offset + size;
+		return {block.buffer->resource, offset, block.buffer->id};
+	}
+
+	void next() {
+		blocks.next();
+		if (!blocks.storage.empty()) { blocks.get().head = {}; }
+	}
+
+  private:
+	bool grow(Block& block, std::size_t const size) {
+		auto const capacity = block.buffer ? block.buffer->size : block_size_v;
+		auto const next_size = std::bit_ceil(std::max(capacity * 2, static_cast<vk::DeviceSize>(size)));
+		device->defer->push(std::move(block.buffer));
+		block.buffer = device->make_buffer({{}, next_size, usage_v}, true);
+		block.head = {};
+		return block.buffer && block.buffer->map;
+	}
+};
+} // namespace vf
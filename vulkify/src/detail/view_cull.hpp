@@ -0,0 +1,71 @@
+#pragma once
+#include <glm/vec2.hpp>
+#include <vulkify/graphics/detail/draw_model.hpp>
+#include <vulkify/graphics/drawable.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <span>
+
+namespace vf {
+///
+/// \brief Tests instances against the region visible through a view (inverted camera) DrawModel
+///
+/// Mirrors the default vertex shader: view(p) = rotate(view.orn, view.scl * p) + view.pos, visible within +-extent / 2.
+/// Instances are treated as circles: geometry radius scaled by the larger of the model and view scales.
+///
+struct ViewCull {
+	glm::vec2 half_extent{};
+	glm::vec2 position{};
+	glm::vec2 orientation{1.0f, 0.0f};
+	glm::vec2 scale{1.0f};
+	float max_scale{1.0f};
+
+	static ViewCull make(DrawModel const& view, glm::vec2 const extent) {
+		auto ret = ViewCull{};
+		ret.half_extent = extent * 0.5f;
+		ret.position = {view.pos_orn.x, view.pos_orn.y};
+		ret.orientation = {view.pos_orn.z, view.pos_orn.w};
+		ret.scale = {view.scl_z_tint.x, view.scl_z_tint.y};
+		ret.max_scale = std::max(std::abs(ret.scale.x), std::abs(ret.scale.y));
+		return ret;
+	}
+
+	///
+	/// \brief Write visibility of each instance (with geometry radius) to out
+	/// \returns Number of visible instances
+	///
+	/// Straight-line arithmetic with no early outs or branches, so the loop auto-vectorises.
+	///
+	std::size_t mask(std::span<DrawInstance const> instances, float const radius, std::uint8_t* out) const {
+		auto const r = radius * max_scale;
+		auto ret = std::size_t{};
+		for (std::size_t i = 0; i < instances.size(); ++i) {
+			auto const& t = instances[i].transform;
+			out[i] = test(t.position, t.scale, r);
+			ret += out[i];
+		}
+		return ret;
+	}
+
+	std::size_t mask(std::span<DrawModel const> models, float const radius, std::uint8_t* out) const {
+		auto const r = radius * max_scale;
+		auto ret = std::size_t{};
+		for (std::size_t i = 0; i < models.size(); ++i) {
+			auto const& m = models[i];
+			out[i] = test({m.pos_orn.x, m.pos_orn.y}, {m.scl_z_tint.x, m.scl_z_tint.y}, r);
+			ret += out[i];
+		}
+		return ret;
+	}
+
+	std::uint8_t test(glm::vec2 const p, glm::vec2 const s, float const r) const {
+		auto const px = p.x * scale.x;
+		auto const py = p.y * scale.y;
+		auto const cx = orientation.x * px - orientation.y * py + position.x;
+		auto const cy = orientation.y * px + orientation.x * py + position.y;
+		auto const ri = r * std::max(std::abs(s.x), std::abs(s.y));
+		return static_cast<std::uint8_t>((std::abs(cx) - ri <= half_extent.x) & (std::abs(cy) - ri <= half_extent.y));
+	}
+};
+} // namespace vf
@@ -51,8 +51,10 @@ struct DescriptorSetLayout {
 struct CombinedImageSampler {
 	vk::ImageView view{};
 	vk::Sampler sampler{};
+	// unique id of the backing allocation (handles may be recycled after destruction)
+	std::uint64_t image{};
 
-	constexpr bool operator==(CombinedImageSampler const& rhs) const { return view == rhs.view && sampler == rhs.sampler; }
+	constexpr bool operator==(CombinedImageSampler const& rhs) const { return view == rhs.view && sampler == rhs.sampler && image == rhs.image; }
 };
 
 struct VulkanInstance;
@@ -60,7 +62,7 @@ struct VulkanInstance;
 struct VulkanDevice {
 	static constexpr auto fence_wait_v = std::numeric_limits<std::uint64_t>::max();
 
-	enum class Flag { eDebugMsgr, eLinearSwp };
+	enum class Flag { eDebugMsgr, eLinearSwp, eDynamicState };
 	using Flags = ktl::enum_flags<Flag, std::uint8_t>;
 
 	Queue queue{};
@@ -68,6 +70,7 @@ struct VulkanDevice {
 	vk::Device device{};
 	std::mutex* queue_mutex{};
 	vk::PhysicalDeviceLimits const* limits{};
+	vk::PhysicalDeviceFeatures const* features{};
 	Flags flags{};
 
 	static VulkanDevice make(VulkanInstance const& instance);
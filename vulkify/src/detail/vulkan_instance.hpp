@@ -1,5 +1,6 @@
 #pragma once
 #include <detail/defer_queue.hpp>
+#include <detail/staged_uploads.hpp>
 #include <detail/vulkan_device.hpp>
 #include <ktl/async/kfunction.hpp>
 #include <vulkify/core/defines.hpp>
@@ -30,7 +31,11 @@ struct PhysicalDevice {
 struct VulkanInstance {
 	struct Util {
 		vk::PhysicalDeviceLimits device_limits{};
+		vk::PhysicalDeviceFeatures device_features{};
+		// VK_EXT_extended_dynamic_state enabled
+		bool dynamic_state{};
 		DeferQueue defer{};
+		StagedUploads uploads{};
 		struct {
 			std::mutex queue{};
 			std::mutex render{};
@@ -41,6 +46,7 @@ struct VulkanInstance {
 		std::vector<char const*> instance_extensions{};
 		MakeSurface make_surface{};
 		std::span<VSync const> desired_vsyncs{};
+		bool headless{};
 	};
 
 	struct Builder;
@@ -52,6 +58,7 @@ struct VulkanInstance {
 	vk::UniqueSurfaceKHR surface{};
 	Queue queue{};
 	ktl::kunique_ptr<Util> util{};
+	bool headless{};
 
 	std::vector<Gpu> available_devices() const;
 };
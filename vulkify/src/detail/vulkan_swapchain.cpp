@@ -61,6 +61,8 @@ vk::SwapchainCreateInfoKHR make_swci(VulkanDevice const& device, std::span<vk::S
 	std::span const targets = linear ? linear_formats_v : srgb_formats_v;
 	ret.imageFormat = image_format(formats, targets);
 	auto const caps = device.gpu.getSurfaceCapabilitiesKHR(surface);
+	// transfer src enables frame readback
+	if (caps.supportedUsageFlags & vk::ImageUsageFlagBits::eTransferSrc) { ret.imageUsage |= vk::ImageUsageFlagBits::eTransferSrc; }
 	ret.imageExtent = image_extent(caps, extent);
 	ret.minImageCount = image_count(caps);
 	return ret;
@@ -1,4 +1,5 @@
 #include <vulkify/core/radian.hpp>
+#include <glm/gtc/packing.hpp>
 #include <vulkify/graphics/geometry.hpp>
 #include <cmath>
 #include <iterator>
@@ -6,6 +7,10 @@
 namespace vf {
 using v2 = glm::vec2;
 
+CompactVertex CompactVertex::make(Vertex const& vertex) { return {vertex.xy, glm::packHalf2x16(vertex.uv), Rgba::make(vertex.rgba)}; }
+
+Vertex CompactVertex::vertex() const { return {xy, glm::unpackHalf2x16(uv), rgba.normalize()}; }
+
 void Geometry::add(std::span<Vertex const> v, std::span<std::uint32_t const> i) {
 	reserve(v.size(), i.size());
 	auto const offset = static_cast<std::uint32_t>(vertices.size());
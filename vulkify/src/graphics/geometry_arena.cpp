@@ -0,0 +1,34 @@
+#include <detail/gfx_allocations.hpp>
+#include <vulkify/graphics/geometry_arena.hpp>
+
+namespace vf {
+GeometryArena::GeometryArena(GfxDevice const& device, VertexFormat format, std::uint32_t vertices, std::uint32_t indices) : GfxDeferred(&device) {
+	auto arena = ktl::make_unique<GfxGeometryArena>(m_device);
+	auto& storage = *arena->storage;
+	storage.vertex_format = format;
+	storage.buffers[0] = BufferCache(m_device, vk::BufferUsageFlagBits::eVertexBuffer);
+	storage.buffers[1] = BufferCache(m_device, vk::BufferUsageFlagBits::eIndexBuffer);
+	storage.vertices.grow(vertices);
+	storage.indices.grow(indices);
+	storage.buffers[0].resize(storage.vertices.capacity * storage.vertex_stride());
+	storage.buffers[1].resize(storage.indices.capacity * sizeof(std::uint32_t));
+	m_allocation = std::move(arena);
+}
+
+VertexFormat GeometryArena::vertex_format() const {
+	auto const* self = static_cast<GfxGeometryArena const*>(m_allocation.get());
+	return self ? self->storage->vertex_format : VertexFormat::eStandard;
+}
+
+std::uint32_t GeometryArena::vertex_capacity() const {
+	auto const* self = static_cast<GfxGeometryArena const*>(m_allocation.get());
+	return self ? self->storage->vertices.capacity : 0;
+}
+
+std::uint32_t GeometryArena::index_capacity() const {
+	auto const* self = static_cast<GfxGeometryArena const*>(m_allocation.get());
+	return self ? self->storage->indices.capacity : 0;
+}
+
+Handle<GeometryArena> GeometryArena::handle() const { return {m_allocation.get()}; }
+} // namespace vf
@@ -1,39 +1,141 @@
+#include <detail/defer_queue.hpp>
 #include <detail/gfx_allocations.hpp>
+#include <vulkify/graphics/geometry_arena.hpp>
 #include <vulkify/graphics/geometry_buffer.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 namespace vf {
 namespace {
-Geometry from_bytes(std::span<std::byte const> verts, std::span<std::byte const> idxs) {
+using u16 = std::uint16_t;
+
+std::vector<CompactVertex> compact(std::span<Vertex const> vertices) {
+	auto ret = std::vector<CompactVertex>(vertices.size());
+	std::transform(vertices.begin(), vertices.end(), ret.begin(), [](Vertex const& v) { return CompactVertex::make(v); });
+	return ret;
+}
+
+std::vector<glm::vec2> positions(std::span<Vertex const> vertices) {
+	auto ret = std::vector<glm::vec2>(vertices.size());
+	std::transform(vertices.begin(), vertices.end(), ret.begin(), [](Vertex const& v) { return v.xy; });
+	return ret;
+}
+
+Geometry from_bytes(std::span<std::byte const> verts, std::span<std::byte const> idxs, vk::IndexType index_type, VertexFormat vertex_format) {
 	auto ret = Geometry{};
-	if (verts.size() > 1) {
+	if (verts.size() > 1 && vertex_format == VertexFormat::eCompact) {
+		assert(verts.size() % sizeof(CompactVertex) == 0);
+		auto cvs = std::vector<CompactVertex>(verts.size() / sizeof(CompactVertex));
+		std::memcpy(cvs.data(), verts.data(), verts.size());
+		ret.vertices.reserve(cvs.size());
+		for (auto const& cv : cvs) { ret.vertices.push_back(cv.vertex()); }
+	} else if (verts.size() > 1 && vertex_format == VertexFormat::ePosition) {
+		assert(verts.size() % sizeof(glm::vec2) == 0);
+		auto xys = std::vector<glm::vec2>(verts.size() / sizeof(glm::vec2));
+		std::memcpy(xys.data(), verts.data(), verts.size());
+		ret.vertices.reserve(xys.size());
+		for (auto const& xy : xys) { ret.vertices.push_back(Vertex::make(xy)); }
+	} else if (verts.size() > 1) {
 		assert(verts.size() % sizeof(decltype(ret.vertices[0])) == 0);
 		ret.vertices.resize(verts.size() / sizeof(decltype(ret.vertices[0])));
 		std::memcpy(ret.vertices.data(), verts.data(), verts.size());
 	}
 	if (idxs.size() > 1) {
-		assert(idxs.size() % sizeof(decltype(ret.indices[0])) == 0);
-		ret.indices.resize(idxs.size() / sizeof(decltype(ret.indices[0])));
-		std::memcpy(ret.indices.data(), idxs.data(), idxs.size());
+		if (index_type == vk::IndexType::eUint16) {
+			assert(idxs.size() % sizeof(u16) == 0);
+			auto idx16 = std::vector<u16>(idxs.size() / sizeof(u16));
+			std::memcpy(idx16.data(), idxs.data(), idxs.size());
+			ret.indices.assign(idx16.begin(), idx16.end());
+		} else {
+			assert(idxs.size() % sizeof(decltype(ret.indices[0])) == 0);
+			ret.indices.resize(idxs.size() / sizeof(decltype(ret.indices[0])));
+			std::memcpy(ret.indices.data(), idxs.data(), idxs.size());
+		}
 	}
 	return ret;
 }
 
-void write_geometry(BufferCache& vbo, BufferCache& ibo, Geometry const& geometry) {
+bool write_vertices(BufferCache& out, std::size_t first, std::span<Vertex const> vertices, VertexFormat format) {
+	if (format == VertexFormat::eCompact) {
+		auto const cvs = compact(vertices);
+		return out.write(first * sizeof(CompactVertex), cvs.data(), cvs.size() * sizeof(CompactVertex));
+	}
+	if (format == VertexFormat::ePosition) {
+		auto const xys = positions(vertices);
+		return out.write(first * sizeof(glm::vec2), xys.data(), xys.size() * sizeof(glm::vec2));
+	}
+	return out.write(first * sizeof(Vertex), vertices.data(), vertices.size_bytes());
+}
+
+void write_arena(GfxGeometryBuffer& out, Geometry const& geometry) {
+	auto& arena = *out.arena;
+	auto const vertices = static_cast<std::uint32_t>(geometry.vertices.size());
+	auto const indices = static_cast<std::uint32_t>(geometry.indices.size());
+	// existing blocks are reused if large enough
+	auto release = GfxGeometryArena::Release(out.arena, {}, {});
+	if (out.vertex_block.count < vertices) {
+		release.vertices = out.vertex_block;
+		out.vertex_block = arena.allocate_vertices(vertices);
+	}
+	if (out.index_block.count < indices) {
+		release.indices = out.index_block;
+		out.index_block = arena.allocate_indices(indices);
+	}
+	// frames in flight may still be drawing from replaced blocks
+	out.device()->defer->push(std::move(release));
+	write_vertices(arena.buffers[0], out.vertex_block.first, geometry.vertices, arena.vertex_format);
+	if (indices > 0) { arena.buffers[1].write(out.index_block.first * sizeof(std::uint32_t), geometry.indices.data(), indices * sizeof(std::uint32_t)); }
+	out.index_type = vk::IndexType::eUint32;
+}
+
+void write_geometry(GfxGeometryBuffer& out, Geometry const& geometry) {
 	assert(!geometry.vertices.empty());
-	vbo.data.resize(geometry.vertices.size() * sizeof(decltype(geometry.vertices[0])));
-	std::memcpy(vbo.data.data(), geometry.vertices.data(), vbo.data.size());
-	if (!geometry.indices.empty()) {
-		ibo.data.resize(geometry.indices.size() * sizeof(decltype(geometry.indices[0])));
-		std::memcpy(ibo.data.data(), geometry.indices.data(), ibo.data.size());
+	if (out.arena) { return write_arena(out, geometry); }
+	if (out.vertex_format == VertexFormat::eCompact) {
+		auto const vertices = compact(geometry.vertices);
+		out.buffers[0].set(vertices.data(), vertices.size() * sizeof(CompactVertex));
+	} else if (out.vertex_format == VertexFormat::ePosition) {
+		auto const vertices = positions(geometry.vertices);
+		out.buffers[0].set(vertices.data(), vertices.size() * sizeof(glm::vec2));
+	} else {
+		out.buffers[0].set(geometry.vertices.data(), geometry.vertices.size() * sizeof(decltype(geometry.vertices[0])));
+	}
+	out.index_type = GfxGeometryBuffer::fits_u16(geometry.vertices.size()) ? vk::IndexType::eUint16 : vk::IndexType::eUint32;
+	if (geometry.indices.empty()) { return; }
+	if (out.index_type == vk::IndexType::eUint16) {
+		auto const indices = GfxGeometryBuffer::narrow(geometry.indices);
+		out.buffers[1].set(indices.data(), indices.size() * sizeof(u16));
+	} else {
+		out.buffers[1].set(geometry.indices.data(), geometry.indices.size() * sizeof(decltype(geometry.indices[0])));
 	}
 }
 } // namespace
 
-GeometryBuffer::GeometryBuffer(GfxDevice const& device) : GfxDeferred(&device) {
+std::vector<std::uint16_t> GfxGeometryBuffer::narrow(std::span<std::uint32_t const> indices) {
+	auto ret = std::vector<u16>(indices.size());
+	std::transform(indices.begin(), indices.end(), ret.begin(), [](std::uint32_t i) { return static_cast<u16>(i); });
+	return ret;
+}
+
+GeometryBuffer::GeometryBuffer(GfxDevice const& device, Usage usage, VertexFormat format) : GfxDeferred(&device) {
 	auto buffer = ktl::make_unique<GfxGeometryBuffer>(m_device);
+	buffer->vertex_format = format;
 	auto& bufs = buffer->buffers;
-	bufs[0] = BufferCache(m_device, vk::BufferUsageFlagBits::eVertexBuffer);
-	bufs[1] = BufferCache(m_device, vk::BufferUsageFlagBits::eIndexBuffer);
+	auto const device_local = usage == Usage::eStatic;
+	bufs[0] = BufferCache(m_device, vk::BufferUsageFlagBits::eVertexBuffer, device_local);
+	bufs[1] = BufferCache(m_device, vk::BufferUsageFlagBits::eIndexBuffer, device_local);
+	m_allocation = std::move(buffer);
+}
+
+GeometryBuffer::GeometryBuffer(GeometryArena& arena) : GfxDeferred(arena ? arena.handle().allocation->device() : nullptr) {
+	auto* gga = static_cast<GfxGeometryArena*>(arena.handle().allocation);
+	if (!gga) { return; }
+	assert(gga->type() == GfxAllocation::Type::eBuffer);
+	auto buffer = ktl::make_unique<GfxGeometryBuffer>(m_device);
+	// shared: the arena may be destroyed before this buffer
+	buffer->arena = gga->storage;
+	buffer->vertex_format = gga->storage->vertex_format;
 	m_allocation = std::move(buffer);
 }
 
@@ -43,18 +145,107 @@ Result<void> GeometryBuffer::write(Geometry geometry) {
 	if (!self || !*self) { return Error::eInactiveInstance; }
 	assert(self->type() == GfxAllocation::Type::eBuffer);
 
-	write_geometry(self->buffers[0], self->buffers[1], geometry);
+	write_geometry(*self, geometry);
 	self->vertices = static_cast<std::uint32_t>(geometry.vertices.size());
 	self->indices = static_cast<std::uint32_t>(geometry.indices.size());
+	auto radius_sq = 0.0f;
+	for (auto const& vertex : geometry.vertices) { radius_sq = std::max(radius_sq, vertex.xy.x * vertex.xy.x + vertex.xy.y * vertex.xy.y); }
+	self->radius = std::sqrt(radius_sq);
 
 	return Result<void>::success();
 }
 
+Result<void> GeometryBuffer::write_range(std::size_t first, std::span<Vertex const> vertices) {
+	auto* self = static_cast<GfxGeometryBuffer*>(m_allocation.get());
+	if (!self || !*self) { return Error::eInactiveInstance; }
+	assert(self->type() == GfxAllocation::Type::eBuffer);
+	if (first + vertices.size() > self->vertices) { return Error::eInvalidArgument; }
+
+	auto& vbo = self->arena ? self->arena->buffers[0] : self->buffers[0];
+	if (!write_vertices(vbo, self->vertex_block.first + first, vertices, self->vertex_format)) { return Error::eMemoryError; }
+	// conservative: only grows, shrinking would require a pass over all vertices
+	auto radius_sq = self->radius * self->radius;
+	for (auto const& vertex : vertices) { radius_sq = std::max(radius_sq, vertex.xy.x * vertex.xy.x + vertex.xy.y * vertex.xy.y); }
+	self->radius = std::sqrt(radius_sq);
+
+	return Result<void>::success();
+}
+
+Result<void> GeometryBuffer::write_range(std::size_t first, std::span<std::uint32_t const> indices) {
+	auto* self = static_cast<GfxGeometryBuffer*>(m_allocation.get());
+	if (!self || !*self) { return Error::eInactiveInstance; }
+	assert(self->type() == GfxAllocation::Type::eBuffer);
+	if (first + indices.size() > self->indices) { return Error::eInvalidArgument; }
+
+	if (self->arena) {
+		auto const offset = (self->index_block.first + first) * sizeof(std::uint32_t);
+		if (!self->arena->buffers[1].write(offset, indices.data(), indices.size_bytes())) { return Error::eMemoryError; }
+	} else if (self->index_type == vk::IndexType::eUint16) {
+		auto const narrowed = GfxGeometryBuffer::narrow(indices);
+		if (!self->buffers[1].write(first * sizeof(u16), narrowed.data(), narrowed.size() * sizeof(u16))) { return Error::eMemoryError; }
+	} else {
+		if (!self->buffers[1].write(first * sizeof(std::uint32_t), indices.data(), indices.size_bytes())) { return Error::eMemoryError; }
+	}
+
+	return Result<void>::success();
+}
+
+auto GeometryBuffer::map(std::uint32_t vertex_count, std::uint32_t index_count) -> Result<Mapped> {
+	if (vertex_count == 0) { return Error::eInvalidArgument; }
+	auto* self = static_cast<GfxGeometryBuffer*>(m_allocation.get());
+	if (!self || !*self) { return Error::eInactiveInstance; }
+	assert(self->type() == GfxAllocation::Type::eBuffer);
+	// arena buffers are shared: sub-allocations are only written through write()
+	if (self->buffers[0].device_local || self->arena) { return Error::eInvalidArgument; }
+
+	auto const vbo = self->buffers[0].map(vertex_count * vertex_stride(self->vertex_format));
+	if (vbo.empty()) { return Error::eMemoryError; }
+	auto ret = Mapped{};
+	if (self->vertex_format == VertexFormat::eCompact) {
+		ret.compact_vertices = {reinterpret_cast<CompactVertex*>(vbo.data()), vertex_count};
+	} else if (self->vertex_format == VertexFormat::ePosition) {
+		ret.positions = {reinterpret_cast<glm::vec2*>(vbo.data()), vertex_count};
+	} else {
+		ret.vertices = {reinterpret_cast<Vertex*>(vbo.data()), vertex_count};
+	}
+	if (index_count > 0) {
+		auto const ibo = self->buffers[1].map(index_count * sizeof(std::uint32_t));
+		if (ibo.empty()) { return Error::eMemoryError; }
+		ret.indices = {reinterpret_cast<std::uint32_t*>(ibo.data()), index_count};
+	}
+	self->vertices = vertex_count;
+	self->indices = index_count;
+	// mapped indices are always 32 bit
+	self->index_type = vk::IndexType::eUint32;
+	// bounds are unknown until drawn: disable culling
+	self->radius = std::numeric_limits<float>::infinity();
+
+	return ret;
+}
+
 Geometry GeometryBuffer::geometry() const {
 	auto const* self = static_cast<GfxGeometryBuffer const*>(m_allocation.get());
 	if (!self) { return {}; }
 	assert(self->type() == GfxAllocation::Type::eBuffer && *self);
-	return from_bytes(self->buffers[0].data, self->buffers[1].data);
+	if (self->arena) {
+		auto const vstride = self->arena->vertex_stride();
+		auto const verts = std::span<std::byte const>(self->arena->buffers[0].data).subspan(self->vertex_block.first * vstride, self->vertices * vstride);
+		auto const idxs = std::span<std::byte const>(self->arena->buffers[1].data).subspan(self->index_block.first * sizeof(std::uint32_t), self->indices * sizeof(std::uint32_t));
+		return from_bytes(verts, idxs, self->index_type, self->vertex_format);
+	}
+	// mapped copies are authoritative
+	auto const idxs = self->indices > 0 ? self->buffers[1].bytes() : std::span<std::byte const>{};
+	return from_bytes(self->buffers[0].bytes(), idxs, self->index_type, self->vertex_format);
+}
+
+VertexFormat GeometryBuffer::vertex_format() const {
+	auto const* self = static_cast<GfxGeometryBuffer const*>(m_allocation.get());
+	return self ? self->vertex_format : VertexFormat::eStandard;
+}
+
+GeometryBuffer::Usage GeometryBuffer::usage() const {
+	auto const* self = static_cast<GfxGeometryBuffer const*>(m_allocation.get());
+	return self && self->buffers[0].device_local ? Usage::eStatic : Usage::eDynamic;
 }
 
 Handle<GeometryBuffer> GeometryBuffer::handle() const { return {m_allocation.get()}; }
@@ -0,0 +1,41 @@
+#include <detail/gfx_allocations.hpp>
+#include <vulkify/graphics/indirect_buffer.hpp>
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace vf {
+static_assert(sizeof(DrawIndirect) == sizeof(vk::DrawIndexedIndirectCommand));
+
+IndirectBuffer::IndirectBuffer(GfxDevice const& device) : GfxDeferred(&device) {
+	auto buffer = ktl::make_unique<GfxIndirectBuffer>(m_device);
+	auto& bufs = buffer->buffers;
+	bufs[0] = BufferCache(m_device, vk::BufferUsageFlagBits::eIndirectBuffer);
+	bufs[1] = BufferCache(m_device, vk::BufferUsageFlagBits::eStorageBuffer);
+	m_allocation = std::move(buffer);
+}
+
+Result<void> IndirectBuffer::write(std::span<DrawIndirect const> commands, std::span<DrawInstance const> instances) {
+	if (!commands.empty() && instances.empty()) { return Error::eInvalidArgument; }
+	auto* self = static_cast<GfxIndirectBuffer*>(m_allocation.get());
+	if (!self || !*self) { return Error::eInactiveInstance; }
+	assert(self->type() == GfxAllocation::Type::eBuffer);
+
+	self->commands.resize(commands.size());
+	std::memcpy(self->commands.data(), commands.data(), commands.size_bytes());
+	self->buffers[0].set(commands.data(), commands.size_bytes());
+	auto models = std::vector<DrawModel>{};
+	models.reserve(instances.size());
+	std::transform(instances.begin(), instances.end(), std::back_inserter(models), [](DrawInstance const& i) { return i.draw_model(); });
+	self->buffers[1].set(models.data(), models.size() * sizeof(DrawModel));
+
+	return Result<void>::success();
+}
+
+std::size_t IndirectBuffer::command_count() const {
+	auto const* self = static_cast<GfxIndirectBuffer const*>(m_allocation.get());
+	return self ? self->commands.size() : 0;
+}
+
+Handle<IndirectBuffer> IndirectBuffer::handle() const { return {m_allocation.get()}; }
+} // namespace vf
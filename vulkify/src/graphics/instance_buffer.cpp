@@ -0,0 +1,54 @@
+#include <detail/gfx_allocations.hpp>
+#include <vulkify/graphics/instance_buffer.hpp>
+#include <algorithm>
+#include <iterator>
+
+namespace vf {
+namespace {
+std::vector<DrawModel> to_models(std::span<DrawInstance const> instances) {
+	auto ret = std::vector<DrawModel>{};
+	ret.reserve(instances.size());
+	std::transform(instances.begin(), instances.end(), std::back_inserter(ret), [](DrawInstance const& i) { return i.draw_model(); });
+	return ret;
+}
+} // namespace
+
+InstanceBuffer::InstanceBuffer(GfxDevice const& device) : GfxDeferred(&device) {
+	auto buffer = ktl::make_unique<GfxInstanceBuffer>(m_device);
+	buffer->buffers[0] = BufferCache(m_device, vk::BufferUsageFlagBits::eStorageBuffer);
+	m_allocation = std::move(buffer);
+}
+
+Result<void> InstanceBuffer::write(std::span<DrawInstance const> instances) { return write(to_models(instances)); }
+
+Result<void> InstanceBuffer::write(std::span<DrawModel const> models) {
+	auto* self = static_cast<GfxInstanceBuffer*>(m_allocation.get());
+	if (!self || !*self) { return Error::eInactiveInstance; }
+	assert(self->type() == GfxAllocation::Type::eBuffer);
+
+	self->buffers[0].set(models.data(), models.size_bytes());
+	self->count = static_cast<std::uint32_t>(models.size());
+
+	return Result<void>::success();
+}
+
+Result<void> InstanceBuffer::write_range(std::size_t first, std::span<DrawInstance const> instances) { return write_range(first, to_models(instances)); }
+
+Result<void> InstanceBuffer::write_range(std::size_t first, std::span<DrawModel const> models) {
+	auto* self = static_cast<GfxInstanceBuffer*>(m_allocation.get());
+	if (!self || !*self) { return Error::eInactiveInstance; }
+	assert(self->type() == GfxAllocation::Type::eBuffer);
+	if (first + models.size() > self->count) { return Error::eInvalidArgument; }
+
+	self->buffers[0].write(first * sizeof(DrawModel), models.data(), models.size_bytes());
+
+	return Result<void>::success();
+}
+
+std::size_t InstanceBuffer::size() const {
+	auto const* self = static_cast<GfxInstanceBuffer const*>(m_allocation.get());
+	return self ? self->count : 0;
+}
+
+Handle<InstanceBuffer> InstanceBuffer::handle() const { return {m_allocation.get()}; }
+} // namespace vf
@@ -0,0 +1,78 @@
+#include <vulkify/graphics/primitives/indirect_mesh.hpp>
+#include <vulkify/graphics/surface.hpp>
+#include <cassert>
+#include <numeric>
+
+namespace vf {
+IndirectMesh::IndirectMesh(GfxDevice const& device, Handle<Texture> texture)
+	: GfxResource(&device), texture(texture), m_buffer(device), m_indirect(device) {}
+
+auto IndirectMesh::add_geometry(Geometry const& geometry) -> Id {
+	auto const range = Range{
+		static_cast<std::uint32_t>(m_geometry.indices.size()),
+		static_cast<std::uint32_t>(geometry.indices.empty() ? geometry.vertices.size() : geometry.indices.size()),
+		static_cast<std::int32_t>(m_geometry.vertices.size()),
+	};
+	m_geometry.vertices.insert(m_geometry.vertices.end(), geometry.vertices.begin(), geometry.vertices.end());
+	if (geometry.indices.empty()) {
+		auto const offset = m_geometry.indices.size();
+		m_geometry.indices.resize(offset + geometry.vertices.size());
+		std::iota(m_geometry.indices.begin() + static_cast<std::ptrdiff_t>(offset), m_geometry.indices.end(), std::uint32_t{});
+	} else {
+		m_geometry.indices.insert(m_geometry.indices.end(), geometry.indices.begin(), geometry.indices.end());
+	}
+	m_ranges.push_back(range);
+	m_dirty.geometry = true;
+	return static_cast<Id>(m_ranges.size() - 1);
+}
+
+auto IndirectMesh::add_object(Id geometry, std::vector<DrawInstance> instances) -> Id {
+	assert(geometry < m_ranges.size());
+	m_objects.push_back({geometry, std::move(instances)});
+	m_dirty.objects = true;
+	return static_cast<Id>(m_objects.size() - 1);
+}
+
+std::vector<DrawInstance>& IndirectMesh::instances(Id object) {
+	assert(object < m_objects.size());
+	m_dirty.objects = true;
+	return m_objects[object].instances;
+}
+
+std::span<DrawInstance const> IndirectMesh::instances(Id object) const {
+	assert(object < m_objects.size());
+	return m_objects[object].instances;
+}
+
+void IndirectMesh::clear() {
+	m_geometry = {};
+	m_ranges.clear();
+	m_objects.clear();
+	m_dirty = {.geometry = false, .objects = true};
+}
+
+void IndirectMesh::draw(Surface const& surface, RenderState const& state) const {
+	refresh();
+	if (m_geometry.vertices.empty() || m_indirect.command_count() == 0) { return; }
+	surface.draw(IndirectDrawable{m_buffer.handle(), m_indirect.handle(), texture}, state);
+}
+
+void IndirectMesh::refresh() const {
+	if (m_dirty.geometry && !m_geometry.vertices.empty()) { m_buffer.write(m_geometry); }
+	if (m_dirty.objects) {
+		auto commands = std::vector<DrawIndirect>{};
+		auto instances = std::vector<DrawInstance>{};
+		commands.reserve(m_objects.size());
+		for (auto const& object : m_objects) {
+			if (object.instances.empty()) { continue; }
+			auto const& range = m_ranges[object.geometry];
+			auto const first_instance = static_cast<std::uint32_t>(instances.size());
+			auto const instance_count = static_cast<std::uint32_t>(object.instances.size());
+			commands.push_back({range.index_count, instance_count, range.first_index, range.vertex_offset, first_instance});
+			instances.insert(instances.end(), object.instances.begin(), object.instances.end());
+		}
+		m_indirect.write(commands, instances);
+	}
+	m_dirty = {};
+}
+} // namespace vf
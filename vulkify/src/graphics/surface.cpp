@@ -2,38 +2,79 @@
 #include <detail/gfx_allocations.hpp>
 #include <detail/pipeline_factory.hpp>
 #include <detail/render_pass.hpp>
+#include <detail/render_worker.hpp>
 #include <detail/trace.hpp>
-#include <ktl/fixed_vector.hpp>
+#include <detail/view_cull.hpp>
 #include <vulkify/graphics/descriptor_set.hpp>
 #include <vulkify/graphics/drawable.hpp>
 #include <vulkify/graphics/geometry_buffer.hpp>
 #include <vulkify/graphics/shader.hpp>
 #include <vulkify/graphics/texture.hpp>
 #include <vulkify/instance/instance.hpp>
+#include <algorithm>
+#include <functional>
 
 namespace vf {
 namespace {
-constexpr vk::PolygonMode polygon_mode(PolygonMode mode) {
-	switch (mode) {
-	case PolygonMode::ePoint: return vk::PolygonMode::ePoint;
-	case PolygonMode::eLine: return vk::PolygonMode::eLine;
-	case PolygonMode::eFill:
-	default: return vk::PolygonMode::eFill;
+// must match projection near / far planes
+constexpr auto z_near_v = -100.0f;
+constexpr auto z_far_v = 100.0f;
+
+[[maybe_unused]] constexpr auto name_v = "vf::(internal)";
+
+DrawModel to_draw_model(DrawInstance const& instance) { return instance.draw_model(); }
+constexpr DrawModel const& to_draw_model(DrawModel const& model) { return model; }
+
+bool record_state(RenderPass const& rp, DrawCommand const& cmd) {
+	if (cmd.custom.active) {
+		auto set = rp.set_factory->post_increment(rp.shader_input.two.set);
+		if (!set) { return false; }
+		auto const bytes = std::span<std::byte const>(rp.draw_list->bytes).subspan(cmd.custom.bytes.offset, cmd.custom.bytes.count);
+		rp.write_custom(set, bytes, cmd.custom.texture);
 	}
+	rp.set_viewport(cmd.view.viewport);
+	rp.set_line_width(cmd.line_width);
+	return true;
 }
 
-constexpr vk::PrimitiveTopology topology(Topology topo) {
-	switch (topo) {
-	case Topology::eLineStrip: return vk::PrimitiveTopology::eLineStrip;
-	case Topology::eLineList: return vk::PrimitiveTopology::eLineList;
-	case Topology::ePointList: return vk::PrimitiveTopology::ePointList;
-	case Topology::eTriangleList: return vk::PrimitiveTopology::eTriangleList;
-	case Topology::eTriangleStrip:
-	default: return vk::PrimitiveTopology::eTriangleStrip;
+// caller must hold the main pass mutex: buffers may be written to after this draw is submitted, which must not affect it
+bool capture(RenderPass const& rp, DrawCommand& cmd, std::vector<vk::DrawIndexedIndirectCommand>& out_commands) {
+	auto const* gbo = static_cast<GfxGeometryBuffer const*>(cmd.buffer.allocation);
+	assert(gbo && gbo->type() == GfxAllocation::Type::eBuffer);
+	auto& geometry = cmd.geometry;
+	geometry.vertices = gbo->vertices;
+	geometry.indices = gbo->indices;
+	geometry.index_type = gbo->index_type;
+	geometry.first_vertex = gbo->vertex_block.first;
+	geometry.first_index = gbo->index_block.first;
+	// nothing written yet (or a static buffer whose upload failed): there is no vertex buffer to bind
+	if (geometry.vertices == 0) { return false; }
+	geometry.vbo = gbo->vbo();
+	geometry.ibo = geometry.indices > 0 ? gbo->ibo() : vk::Buffer{};
+	if (!geometry.vbo || (geometry.indices > 0 && !geometry.ibo)) { return false; }
+	if (cmd.instances) {
+		auto const* gib = static_cast<GfxInstanceBuffer const*>(cmd.instances.allocation);
+		assert(gib && gib->type() == GfxAllocation::Type::eBuffer);
+		// only ranges modified since this copy was last used are uploaded
+		auto const& buffer = gib->buffers[0].acquire();
+		cmd.resident.models = {buffer.resource, {}, buffer.id};
+		cmd.resident.count = gib->count;
+	}
+	if (cmd.indirect) {
+		auto const* gib = static_cast<GfxIndirectBuffer const*>(cmd.indirect.allocation);
+		assert(gib && gib->type() == GfxAllocation::Type::eBuffer);
+		// indirect commands index the whole buffer: arena sub-allocations are not supported
+		if (gib->commands.empty() || geometry.indices == 0 || gbo->arena) { return false; }
+		auto const& models = gib->buffers[1].acquire();
+		cmd.resident.args = gib->buffers[0].acquire().resource;
+		cmd.resident.models = {models.resource, {}, models.id};
+		cmd.resident.count = static_cast<std::uint32_t>(gib->commands.size());
+		auto const* features = rp.device->device.features;
+		// without drawIndirectFirstInstance, indirect commands cannot offset instances: record each one directly instead
+		if (!features || !features->drawIndirectFirstInstance) { out_commands = gib->commands; }
 	}
+	return true;
 }
-
-[[maybe_unused]] constexpr auto name_v = "vf::(internal)";
 } // namespace
 
 DescriptorSet::DescriptorSet(ktl::not_null<Shader const*> shader) : m_shader(shader->handle()) {}
@@ -42,33 +83,60 @@ CombinedImageSampler RenderPass::image_sampler(Handle<Texture> texture) const {
 	auto const image = static_cast<GfxImage const*>(texture.allocation);
 	if (!image) { return white_texture(); }
 	assert(image->type() == GfxAllocation::Type::eImage);
-	if (image->image.cache.view && image->image.sampler) { return CombinedImageSampler{*image->image.cache.view, *image->image.sampler}; }
+	if (image->image.cache.view && image->image.sampler) { return CombinedImageSampler{*image->image.cache.view, *image->image.sampler, image->image.cache.image->id}; }
 	return white_texture();
 }
 
-CombinedImageSampler RenderPass::white_texture() const { return CombinedImageSampler{*shader_input.textures->white.view, *shader_input.textures->sampler}; }
+CombinedImageSampler RenderPass::white_texture() const {
+	auto const& white = shader_input.textures->white;
+	return CombinedImageSampler{*white.view, *shader_input.textures->sampler, white.image->id};
+}
 
-void RenderPass::write_view(SetWriter& set) const {
+DrawView RenderPass::view() const {
+	auto const scale = cam.camera->view.get_scale(cam.extent);
+	// invert transformation
+	auto const dm = DrawModel{{-cam.camera->position, cam.camera->orientation.inverted().value()}, {scale, glm::vec2()}};
+	auto const vp = Rect{{cam.extent * cam.camera->viewport.extent, cam.extent * cam.camera->viewport.offset}};
+	return {dm, vk::Viewport(vp.offset.x, vp.offset.y + vp.extent.y, vp.extent.x, -vp.extent.y)}; // flip x / negative y
+}
+
+void RenderPass::write_view(SetWriter& set, DrawModel const& view) const {
 	if (!set) {
 		VF_TRACE(name_v, trace::Type::eWarn, "Failed to write view set");
 		return;
 	}
-	auto const scale = cam.camera->view.get_scale(cam.extent);
-	// invert transformation
-	auto const dm = DrawModel{{-cam.camera->position, cam.camera->orientation.inverted().value()}, {scale, glm::vec2()}};
-	set.write(shader_input.one.bindings.ubo, &dm, sizeof(dm));
+	auto& ring = *set.ring;
+	auto const& cached = view_ubo.model;
+	// the view only changes with the camera: rewrite it then, or when the ring has moved on to a new buffer
+	if (!view_ubo.alloc || view_ubo.alloc.id != ring.buffer_id() || cached.pos_orn != view.pos_orn || cached.scl_z_tint != view.scl_z_tint) {
+		view_ubo.alloc = ring.write(&view, sizeof(view), ring.ubo_alignment);
+		view_ubo.model = view;
+	}
+	set.write(shader_input.one.bindings.ubo, view_ubo.alloc, sizeof(view));
 }
 
-void RenderPass::write_models(SetWriter& set, std::span<DrawModel const> instances, Handle<Texture> texture) const {
-	auto const tex = image_sampler(texture);
+std::optional<std::uint32_t> RenderPass::write_models(SetWriter& set, std::span<DrawModel const> instances, CombinedImageSampler const& tex) const {
 	if (!set || instances.empty() || !tex.sampler || !tex.view) {
 		VF_TRACE(name_v, trace::Type::eWarn, "Failed to write models set");
-		return;
+		return {};
 	}
 	auto const& sb = shader_input.one;
-	set.write(sb.bindings.ssbo, instances.data(), instances.size_bytes());
-	set.update(sb.bindings.sampler, tex.sampler, tex.view);
-	set.bind(command_buffer, bound);
+	auto const ret = set.write_array(sb.bindings.ssbo, instances);
+	set.update(sb.bindings.sampler, tex);
+	bind_set(set);
+	return ret;
+}
+
+bool RenderPass::write_instances(SetWriter& set, UploadRing::Alloc const& instances, CombinedImageSampler const& tex) const {
+	if (!set || !instances || !tex.sampler || !tex.view) {
+		VF_TRACE(name_v, trace::Type::eWarn, "Failed to write instances set");
+		return false;
+	}
+	auto const& sb = shader_input.one;
+	set.write_buffer(sb.bindings.ssbo, instances);
+	set.update(sb.bindings.sampler, tex);
+	bind_set(set);
+	return true;
 }
 
 void RenderPass::write_custom(SetWriter& set, std::span<std::byte const> ubo, Handle<Texture> texture) const {
@@ -81,100 +149,336 @@ void RenderPass::write_custom(SetWriter& set, std::span<std::byte const> ubo, Ha
 	if (ubo.empty()) { ubo = {&byte_v, 1}; }
 	auto const& sb = shader_input.two;
 	set.write(sb.bindings.ubo, ubo.data(), ubo.size_bytes());
-	set.update(sb.bindings.sampler, tex.sampler, tex.view);
-	set.bind(command_buffer, bound);
+	set.update(sb.bindings.sampler, tex);
+	bind_set(set);
 }
 
 void RenderPass::bind(vk::PipelineLayout layout, vk::Pipeline pipeline) const {
-	if (layout == bound) { return; }
+	if (layout == bound) {
+		stats.pipelines(false);
+		return;
+	}
 	if (!layout || !command_buffer) {
 		VF_TRACE(name_v, trace::Type::eWarn, "Failed to bind pipeline");
 		return;
 	}
+	stats.pipelines(true);
 	command_buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
-	shader_input.mat_p.bind(command_buffer, layout);
 	bound = layout;
+	std::fill(std::begin(bound_sets), std::end(bound_sets), BoundSet{});
+	bind_set(shader_input.mat_p);
 }
 
-void RenderPass::set_viewport() const {
-	if (!command_buffer || !cam.camera) {
+void RenderPass::bind_set(SetWriter const& set) const {
+	if (!set || !bound || set.number >= max_sets_v) { return; }
+	// sets are shared across draws (and models are selected via firstInstance): skip if nothing changed
+	auto& last = bound_sets[set.number];
+	auto const record = last.set != set.set || last.dynamic_offset != set.dynamic_offset;
+	stats.descriptor_sets(record);
+	if (!record) { return; }
+	set.bind(command_buffer, bound);
+	last = {set.set, set.dynamic_offset};
+}
+
+void RenderPass::set_viewport(vk::Viewport const& viewport) const {
+	if (!command_buffer) {
 		VF_TRACE(name_v, trace::Type::eWarn, "Failed to set viewport");
 		return;
 	}
-	auto const vp = Rect{{cam.extent * cam.camera->viewport.extent, cam.extent * cam.camera->viewport.offset}};
-	command_buffer.setViewport(0, vk::Viewport(vp.offset.x, vp.offset.y + vp.extent.y, vp.extent.x, -vp.extent.y)); // flip x / negative y
+	auto const record = bound_state.viewport != viewport;
+	stats.viewports(record);
+	if (!record) { return; }
+	command_buffer.setViewport(0, viewport);
+	bound_state.viewport = viewport;
+}
+
+void RenderPass::set_line_width(float line_width) const {
+	auto const record = bound_state.line_width != line_width;
+	stats.line_widths(record);
+	if (!record) { return; }
+	command_buffer.setLineWidth(line_width);
+	bound_state.line_width = line_width;
+}
+
+void RenderPass::bind_vbo(vk::Buffer buffer, VertexFormat format) const {
+	if (format == VertexFormat::ePosition && !bound_state.vertex_defaults) {
+		// not affected by pipeline binds: recorded once per pass
+		command_buffer.bindVertexBuffers(1, shader_input.textures->vertex->resource, vk::DeviceSize{});
+		bound_state.vertex_defaults = true;
+	}
+	auto const record = bound_state.vbo != buffer;
+	stats.vertex_buffers(record);
+	if (!record) { return; }
+	command_buffer.bindVertexBuffers(0, buffer, vk::DeviceSize{});
+	bound_state.vbo = buffer;
+}
+
+void RenderPass::bind_ibo(vk::Buffer buffer, vk::IndexType type) const {
+	auto const record = bound_state.ibo != buffer || bound_state.index_type != type;
+	stats.index_buffers(record);
+	if (!record) { return; }
+	command_buffer.bindIndexBuffer(buffer, vk::DeviceSize{}, type);
+	bound_state.ibo = buffer;
+	bound_state.index_type = type;
+}
+
+bool RenderPass::bind(PipelineFactory::Spec const& spec) const {
+	// specs differing only in dynamic state resolve to the same pipeline
+	auto const key = pipeline_factory->resolve(spec);
+	if (!last_pipeline.pipeline || !(last_pipeline.spec == key)) {
+		auto lock = lock_shared();
+		auto const [pipe, layout] = pipeline_factory->pipeline(key, render_pass);
+		lock = {};
+		if (!pipe || !layout) { return false; }
+		last_pipeline = {key, pipe, layout};
+	}
+	bind(last_pipeline.layout, last_pipeline.pipeline);
+	if (pipeline_factory->dynamic_state) { set_dynamic_state(spec.topology, spec.depth_test); }
+	return true;
+}
+
+void RenderPass::set_dynamic_state(vk::PrimitiveTopology topology, bool depth_test) const {
+	auto const record = !dynamic_state.set || dynamic_state.topology != topology || dynamic_state.depth_test != depth_test;
+	stats.dynamic_states(record);
+	if (!record) { return; }
+	if (!dynamic_state.set || dynamic_state.topology != topology) { command_buffer.setPrimitiveTopologyEXT(topology); }
+	if (!dynamic_state.set || dynamic_state.depth_test != depth_test) {
+		command_buffer.setDepthTestEnableEXT(depth_test);
+		command_buffer.setDepthWriteEnableEXT(depth_test);
+	}
+	dynamic_state = {topology, depth_test, true};
+}
+
+bool DrawCommand::batches_with(DrawCommand const& rhs) const {
+	if (custom.active || rhs.custom.active || indirect || rhs.indirect || instances || rhs.instances) { return false; }
+	return spec == rhs.spec && geometry == rhs.geometry && texture == rhs.texture && line_width == rhs.line_width && view == rhs.view;
+}
+
+std::uint64_t DrawList::make_key(PipelineFactory::Spec const& spec, Handle<Texture> texture, float z) {
+	// fold all bits of the hash into 16
+	auto pipe = static_cast<std::uint64_t>(spec.hash());
+	pipe ^= pipe >> 32;
+	pipe ^= pipe >> 16;
+	auto const tex = std::hash<void const*>{}(texture.allocation) >> 4;
+	// larger z is closer: invert so that closer draws sort first
+	static constexpr auto depth_max_v = float((1 << 24) - 1);
+	auto const t = std::clamp((z - z_near_v) / (z_far_v - z_near_v), 0.0f, 1.0f);
+	auto const depth = static_cast<std::uint64_t>((1.0f - t) * depth_max_v);
+	return (std::uint64_t(pipe & 0xffff) << 48) | (std::uint64_t(tex & 0xffffff) << 24) | depth;
+}
+
+void DrawList::sort_opaque() {
+	auto const by_key = [](DrawCommand const& a, DrawCommand const& b) { return a.key < b.key; };
+	auto it = commands.begin();
+	while (it != commands.end()) {
+		it = std::find_if(it, commands.end(), [](DrawCommand const& c) { return sortable(c.spec); });
+		auto const last = std::find_if(it, commands.end(), [](DrawCommand const& c) { return !sortable(c.spec); });
+		std::stable_sort(it, last, by_key);
+		it = last;
+	}
 }
 
 Surface::~Surface() {
-	if (m_render_pass && m_render_pass->instance) { m_render_pass->instance.value->end_pass(); }
+	if (!m_render_pass || !m_render_pass->instance) { return; }
+	if (m_render_pass->worker) {
+		// worker surface: finish its command buffer, which the owning pass executes at end_pass
+		if (m_render_pass->worker->recording) {
+			flush();
+			m_render_pass->worker->end();
+		}
+		return;
+	}
+	flush();
+	m_render_pass->instance.value->end_pass();
 }
 
 Surface::operator bool() const { return m_render_pass && m_render_pass->instance; }
 
 bool Surface::draw(Drawable const& drawable, RenderState const& state) const {
-	if (!m_render_pass || !m_render_pass->pipeline_factory || !m_render_pass->render_pass) { return false; }
-	if (drawable.instances.empty() || !drawable.buffer) { return false; }
-	if (drawable.instances.size() <= small_buffer_v) {
-		auto buffer = ktl::fixed_vector<DrawModel, small_buffer_v>{};
-		add_draw_models(drawable.instances, std::back_inserter(buffer));
-		return draw(buffer, drawable, state);
+	if ((drawable.instances.empty() && drawable.models.empty() && !drawable.instance_buffer) || !drawable.buffer) { return false; }
+	auto cmd = DrawCommand{};
+	cmd.buffer = drawable.buffer;
+	cmd.texture = drawable.texture;
+	if (drawable.instance_buffer) {
+		// GPU resident: nothing to convert, cull, or upload
+		cmd.instances = drawable.instance_buffer;
+		return push(std::move(cmd), state, std::span<DrawInstance const>{}, false);
+	}
+	if (!drawable.models.empty()) { return push(std::move(cmd), state, drawable.models, true); }
+	return push(std::move(cmd), state, drawable.instances, true);
+}
+
+bool Surface::draw(IndirectDrawable const& drawable, RenderState const& state) const {
+	if (!drawable.buffer || !drawable.indirect) { return false; }
+	auto cmd = DrawCommand{};
+	cmd.buffer = drawable.buffer;
+	cmd.texture = drawable.texture;
+	cmd.indirect = drawable.indirect;
+	return push(std::move(cmd), state, std::span<DrawInstance const>{}, false);
+}
+
+template <typename T>
+bool Surface::push(DrawCommand cmd, RenderState const& state, std::span<T const> instances, bool cull) const {
+	if (!m_render_pass || !m_render_pass->draw_list || !m_render_pass->render_mutex || !m_render_pass->cam.camera) { return false; }
+	cull &= m_render_pass->draw_list->cull;
+	auto radius = 0.0f;
+	auto commands = std::vector<vk::DrawIndexedIndirectCommand>{};
+	{
+		auto lock = m_render_pass->lock_main();
+		if (!capture(*m_render_pass, cmd, commands)) { return false; }
+		radius = static_cast<GfxGeometryBuffer const*>(cmd.buffer.allocation)->radius;
+	}
+	auto const shader = state.descriptor_set ? state.descriptor_set->m_shader : Handle<Shader>{};
+	// fixed at construction: no lock required
+	auto const vertex_format = cmd.buffer.allocation ? static_cast<GfxGeometryBuffer const*>(cmd.buffer.allocation)->vertex_format : VertexFormat{};
+	cmd.spec = PipelineFactory::Spec::make(state, shader, m_render_pass->device->default_z_order, vertex_format);
+	cmd.line_width = std::clamp(state.line_width, m_render_pass->line_width_limit.first, m_render_pass->line_width_limit.second);
+
+	auto lock = std::scoped_lock(*m_render_pass->render_mutex);
+	auto& list = *m_render_pass->draw_list;
+	cmd.view = m_render_pass->view();
+	if (cull) {
+		// drop instances outside the view before they are converted and uploaded
+		list.visible.resize(instances.size());
+		auto const count = ViewCull::make(cmd.view.model, m_render_pass->cam.extent).mask(instances, radius, list.visible.data());
+		if (count == 0) { return true; }
+		cmd.models = {list.models.size(), count};
+		list.models.reserve(list.models.size() + count);
+		for (std::size_t i = 0; i < instances.size(); ++i) {
+			if (list.visible[i]) { list.models.push_back(to_draw_model(instances[i])); }
+		}
 	} else {
-		auto buffer = std::vector<DrawModel>{};
-		buffer.reserve(drawable.instances.size());
-		add_draw_models(drawable.instances, std::back_inserter(buffer));
-		return draw(buffer, drawable, state);
+		cmd.models = {list.models.size(), instances.size()};
+		if constexpr (std::same_as<T, DrawModel>) {
+			// already in GPU layout: bulk copy
+			list.models.insert(list.models.end(), instances.begin(), instances.end());
+		} else {
+			add_draw_models(instances, std::back_inserter(list.models));
+		}
 	}
+	if (state.descriptor_set) {
+		// snapshot custom data: the descriptor set may be modified or destroyed before the pass ends
+		auto const& bytes = state.descriptor_set->m_data.bytes;
+		cmd.custom = {{list.bytes.size(), bytes.size()}, state.descriptor_set->m_data.texture, true};
+		list.bytes.insert(list.bytes.end(), bytes.begin(), bytes.end());
+	}
+	if (!commands.empty()) {
+		cmd.resident.commands = {list.indirect.size(), commands.size()};
+		list.indirect.insert(list.indirect.end(), commands.begin(), commands.end());
+	}
+	auto const z = instances.empty() ? 0.0f : list.models[cmd.models.offset].scl_z_tint.z;
+	cmd.key = DrawList::make_key(cmd.spec, cmd.texture, z);
+	list.commands.push_back(cmd);
+	return true;
 }
 
 bool Surface::bind(RenderState const& state) const {
-	if (!m_render_pass) { return false; }
-	auto program = PipelineFactory::Spec::ShaderProgram{};
-	if (state.descriptor_set && state.descriptor_set->m_shader && state.descriptor_set->m_shader.allocation) {
-		assert(state.descriptor_set->m_shader.allocation->type() == GfxAllocation::Type::eShader);
-		program.frag = *static_cast<GfxShader const*>(state.descriptor_set->m_shader.allocation)->module;
-	}
-	auto const spec = PipelineFactory::Spec{
-		.shader = program,
-		.mode = polygon_mode(state.polygon_mode),
-		.topology = topology(state.topology),
-		.depth_test = state.force_z_order.value_or(m_render_pass->device->default_z_order) == ZOrder::eOn,
-	};
-	auto const [pipe, layout] = m_render_pass->pipeline_factory->pipeline(spec, m_render_pass->render_pass);
-	if (!pipe || !layout) { return false; }
-	m_render_pass->bind(layout, pipe);
-	return true;
+	if (!m_render_pass || !m_render_pass->pipeline_factory) { return false; }
+	auto const shader = state.descriptor_set ? state.descriptor_set->m_shader : Handle<Shader>{};
+	return m_render_pass->bind(PipelineFactory::Spec::make(state, shader, m_render_pass->device->default_z_order));
 }
 
-bool Surface::draw(std::span<DrawModel const> models, Drawable const& drawable, RenderState const& state) const {
-	if (!m_render_pass || !m_render_pass->pipeline_factory || !m_render_pass->render_pass || !m_render_pass->render_mutex) { return false; }
-	if (drawable.instances.empty() || !drawable.buffer) { return false; }
+void Surface::flush() const {
+	if (!m_render_pass || !m_render_pass->draw_list || !m_render_pass->render_mutex) { return; }
 	auto lock = std::scoped_lock(*m_render_pass->render_mutex);
-	if (!bind(state)) { return false; }
+	auto& list = *m_render_pass->draw_list;
+	if (list.sort) { list.sort_opaque(); }
+	auto const& commands = list.commands;
+	for (std::size_t i = 0; i < commands.size();) {
+		auto const& first = commands[i];
+		auto models = std::span<DrawModel const>(list.models).subspan(first.models.offset, first.models.count);
+		auto next = i + 1;
+		if (list.batch) {
+			while (next < commands.size() && first.batches_with(commands[next])) { ++next; }
+			if (next > i + 1) {
+				list.scratch.clear();
+				for (auto j = i; j < next; ++j) {
+					auto const range = std::span<DrawModel const>(list.models).subspan(commands[j].models.offset, commands[j].models.count);
+					list.scratch.insert(list.scratch.end(), range.begin(), range.end());
+				}
+				models = list.scratch;
+			}
+		}
+		if (first.indirect) {
+			record_indirect(first);
+		} else {
+			record(first, models);
+		}
+		i = next;
+	}
+	list.clear();
+}
 
-	auto set = m_render_pass->set_factory->post_increment(m_render_pass->shader_input.one.set);
+bool Surface::record(DrawCommand const& cmd, std::span<DrawModel const> models) const {
+	auto const& geometry = cmd.geometry;
+	auto persistent = UploadRing::Alloc{};
+	auto instanceCount = static_cast<std::uint32_t>(models.size());
+	if (cmd.instances) {
+		persistent = cmd.resident.models;
+		instanceCount = cmd.resident.count;
+	}
+	if (instanceCount == 0 || geometry.vertices == 0 || !geometry.vbo) { return false; }
+
+	if (!m_render_pass->bind(cmd.spec)) { return false; }
+
+	// set 1 is shared by all draws with the same texture this frame: only its dynamic offset and firstInstance differ
+	auto const tex = m_render_pass->image_sampler(cmd.texture);
+	auto const reserve = sizeof(DrawModel) + m_render_pass->set_factory->ring->ubo_alignment + models.size_bytes() + sizeof(DrawModel);
+	auto set = m_render_pass->set_factory->shared(m_render_pass->shader_input.one.set, tex, reserve, persistent.id);
 	if (!set) { return false; }
-	m_render_pass->write_view(set);
-	m_render_pass->write_models(set, models, drawable.texture);
-	if (state.descriptor_set) {
-		set = m_render_pass->set_factory->post_increment(m_render_pass->shader_input.two.set);
-		if (!set) { return false; }
-		m_render_pass->write_custom(set, state.descriptor_set->m_data.bytes, state.descriptor_set->m_data.texture);
+	m_render_pass->write_view(set, cmd.view.model);
+	auto first_instance = std::optional<std::uint32_t>{0U};
+	if (persistent) {
+		if (!m_render_pass->write_instances(set, persistent, tex)) { return false; }
+	} else {
+		// instances live in the (shared) upload ring buffer: firstInstance offsets gl_InstanceIndex to this draw's models
+		first_instance = m_render_pass->write_models(set, models, tex);
 	}
-	m_render_pass->set_viewport();
-	auto const lineWidth = std::clamp(state.line_width, m_render_pass->line_width_limit.first, m_render_pass->line_width_limit.second);
-	m_render_pass->command_buffer.setLineWidth(lineWidth);
+	if (!first_instance) { return false; }
+	if (!record_state(*m_render_pass, cmd)) { return false; }
 
-	auto const* gbo = static_cast<GfxGeometryBuffer const*>(drawable.buffer.allocation);
-	assert(gbo && gbo->type() == GfxAllocation::Type::eBuffer);
-	auto const& vbo = gbo->buffers[0].get(true);
-	m_render_pass->command_buffer.bindVertexBuffers(0, vbo.resource, vk::DeviceSize{});
-	auto const instanceCount = static_cast<std::uint32_t>(models.size());
-	if (gbo->indices > 0) {
-		auto const& ibo = gbo->buffers[1].get(true);
-		m_render_pass->command_buffer.bindIndexBuffer(ibo.resource, vk::DeviceSize{}, vk::IndexType::eUint32);
-		m_render_pass->command_buffer.drawIndexed(gbo->indices, instanceCount, 0, 0, 0);
+	m_render_pass->bind_vbo(geometry.vbo, cmd.spec.vertex_format);
+	++m_render_pass->stats.draws;
+	if (geometry.indices > 0) {
+		m_render_pass->bind_ibo(geometry.ibo, geometry.index_type);
+		auto const vertex_offset = static_cast<std::int32_t>(geometry.first_vertex);
+		m_render_pass->command_buffer.drawIndexed(geometry.indices, instanceCount, geometry.first_index, vertex_offset, *first_instance);
+	} else {
+		m_render_pass->command_buffer.draw(geometry.vertices, instanceCount, geometry.first_vertex, *first_instance);
+	}
+	return true;
+}
+
+bool Surface::record_indirect(DrawCommand const& cmd) const {
+	if (!m_render_pass->bind(cmd.spec)) { return false; }
+
+	auto const* features = m_render_pass->device->device.features;
+	auto const first_instance = features && features->drawIndirectFirstInstance;
+	auto const& instances = cmd.resident.models;
+	auto const count = cmd.resident.count;
+	if (!instances || !cmd.resident.args || count == 0) { return false; }
+
+	auto const tex = m_render_pass->image_sampler(cmd.texture);
+	auto const reserve = sizeof(DrawModel) + m_render_pass->set_factory->ring->ubo_alignment;
+	auto set = m_render_pass->set_factory->shared(m_render_pass->shader_input.one.set, tex, reserve, instances.id);
+	if (!set) { return false; }
+	m_render_pass->write_view(set, cmd.view.model);
+	if (!m_render_pass->write_instances(set, instances, tex)) { return false; }
+	if (!record_state(*m_render_pass, cmd)) { return false; }
+
+	auto const cb = m_render_pass->command_buffer;
+	m_render_pass->bind_vbo(cmd.geometry.vbo, cmd.spec.vertex_format);
+	m_render_pass->bind_ibo(cmd.geometry.ibo, cmd.geometry.index_type);
+	++m_render_pass->stats.draws;
+	if (first_instance) {
+		static constexpr auto stride_v = static_cast<std::uint32_t>(sizeof(vk::DrawIndexedIndirectCommand));
+		auto const max_count = features->multiDrawIndirect ? std::max(m_render_pass->device->device_limits->maxDrawIndirectCount, 1U) : 1U;
+		for (std::uint32_t first = 0; first < count; first += max_count) {
+			cb.drawIndexedIndirect(cmd.resident.args, first * vk::DeviceSize{stride_v}, std::min(max_count, count - first), stride_v);
+		}
 	} else {
-		m_render_pass->command_buffer.draw(gbo->vertices, instanceCount, 0, 0);
+		auto const commands = std::span<vk::DrawIndexedIndirectCommand const>(m_render_pass->draw_list->indirect).subspan(cmd.resident.commands.offset, cmd.resident.commands.count);
+		for (auto const& c : commands) { cb.drawIndexed(c.indexCount, c.instanceCount, c.firstIndex, c.vertexOffset, c.firstInstance); }
 	}
 	return true;
 }
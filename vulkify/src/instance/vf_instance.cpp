@@ -8,16 +8,20 @@
 
 #include <detail/descriptor_set_factory.hpp>
 #include <detail/pipeline_factory.hpp>
+#include <detail/readback_ring.hpp>
 #include <detail/render_pass.hpp>
+#include <detail/render_worker.hpp>
 #include <detail/renderer.hpp>
 #include <detail/rotator.hpp>
 #include <detail/trace.hpp>
 #include <detail/window/window.hpp>
+#include <chrono>
 #include <functional>
 
 #include <glm/mat4x4.hpp>
 #include <vulkify/graphics/bitmap.hpp>
 #include <vulkify/graphics/camera.hpp>
+#include <vulkify/graphics/descriptor_set.hpp>
 #include <vulkify/graphics/geometry.hpp>
 #include <iostream>
 
@@ -116,19 +120,44 @@ std::vector<vk::DescriptorSetLayout> make_set_layouts(std::span<vk::UniqueDescri
 
 namespace {
 struct VertexInputStorage {
-	std::vector<vk::VertexInputBindingDescription> bindings{};
-	std::vector<vk::VertexInputAttributeDescription> attributes{};
+	struct Format {
+		std::vector<vk::VertexInputBindingDescription> bindings{};
+		std::vector<vk::VertexInputAttributeDescription> attributes{};
+	};
 
-	VertexInput operator()() const { return {bindings, attributes}; }
+	// indexed by VertexFormat
+	Format formats[3]{};
+
+	VertexInputs operator()() const {
+		auto ret = VertexInputs{};
+		for (std::size_t i = 0; i < ret.size(); ++i) { ret[i] = {formats[i].bindings, formats[i].attributes}; }
+		return ret;
+	}
 
 	static VertexInputStorage make() {
 		auto ret = VertexInputStorage{};
-		auto vertex = vk::VertexInputBindingDescription(0, sizeof(Vertex));
-		ret.bindings = {vertex};
+		auto& standard = ret.formats[static_cast<std::size_t>(VertexFormat::eStandard)];
+		standard.bindings = {vk::VertexInputBindingDescription(0, sizeof(Vertex))};
 		auto xy = vk::VertexInputAttributeDescription(0, 0, vk::Format::eR32G32Sfloat, offsetof(Vertex, xy));
 		auto uv = vk::VertexInputAttributeDescription(1, 0, vk::Format::eR32G32Sfloat, offsetof(Vertex, uv));
 		auto rgba = vk::VertexInputAttributeDescription(2, 0, vk::Format::eR32G32B32A32Sfloat, offsetof(Vertex, rgba));
-		ret.attributes = {xy, uv, rgba};
+		standard.attributes = {xy, uv, rgba};
+
+		// same shader inputs: uv and rgba are expanded to floats by the vertex input stage
+		auto& compact = ret.formats[static_cast<std::size_t>(VertexFormat::eCompact)];
+		compact.bindings = {vk::VertexInputBindingDescription(0, sizeof(CompactVertex))};
+		xy = vk::VertexInputAttributeDescription(0, 0, vk::Format::eR32G32Sfloat, offsetof(CompactVertex, xy));
+		uv = vk::VertexInputAttributeDescription(1, 0, vk::Format::eR16G16Sfloat, offsetof(CompactVertex, uv));
+		rgba = vk::VertexInputAttributeDescription(2, 0, vk::Format::eR8G8B8A8Unorm, offsetof(CompactVertex, rgba));
+		compact.attributes = {xy, uv, rgba};
+
+		// same shader inputs: uv and rgba are read from a single Vertex (ShaderInput::Textures::vertex) bound with zero stride
+		auto& position = ret.formats[static_cast<std::size_t>(VertexFormat::ePosition)];
+		position.bindings = {vk::VertexInputBindingDescription(0, sizeof(glm::vec2)), vk::VertexInputBindingDescription(1, 0)};
+		xy = vk::VertexInputAttributeDescription(0, 0, vk::Format::eR32G32Sfloat, 0);
+		uv = vk::VertexInputAttributeDescription(1, 1, vk::Format::eR32G32Sfloat, offsetof(Vertex, uv));
+		rgba = vk::VertexInputAttributeDescription(2, 1, vk::Format::eR32G32B32A32Sfloat, offsetof(Vertex, rgba));
+		position.attributes = {xy, uv, rgba};
 		return ret;
 	}
 };
@@ -170,10 +199,12 @@ struct SwapchainRenderer {
 	ImageView present{};
 	Rgba clear{};
 	bool msaa{};
+	bool offscreen{};
 
-	static SwapchainRenderer make(GfxDevice const* device, vk::Format format) {
+	static SwapchainRenderer make(GfxDevice const* device, vk::Format format, bool offscreen = false) {
 		assert(device);
 		auto ret = SwapchainRenderer{device};
+		ret.offscreen = offscreen;
 		auto renderer = Renderer::make(device->device.device, format, device->colour_samples);
 		if (!renderer.render_pass) { return {}; }
 		ret.renderer = std::move(renderer);
@@ -243,12 +274,14 @@ struct SwapchainRenderer {
 		return sync.cmd.secondary;
 	}
 
-	vk::CommandBuffer end_render() {
+	vk::CommandBuffer end_render(ReadbackRing* readback = {}, std::span<vk::CommandBuffer const> workers = {}) {
 		if (!renderer.render_pass || !framebuffer) { return {}; }
 
 		auto& sync = frame_sync.get();
 		sync.cmd.secondary.end();
 		sync.cmd.primary.begin({vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+		// ranges of static buffers drawn this frame: uploaded before the render pass
+		if (device->uploads) { device->uploads->record(sync.cmd.primary); }
 
 		auto images = ktl::fixed_vector<ImageView, 2>{framebuffer.colour};
 		if (msaa) { images.push_back(framebuffer.resolve); }
@@ -256,8 +289,16 @@ struct SwapchainRenderer {
 		auto frame = Renderer::Frame{renderer, framebuffer, sync.cmd.primary};
 		frame.undef_to_depth(framebuffer.depth);
 		frame.undef_to_colour(images);
-		frame.render(clear, {&sync.cmd.secondary, 1});
-		frame.colour_to_present({present.image, present.view, present.extent});
+		auto recorded = std::vector<vk::CommandBuffer>{sync.cmd.secondary};
+		recorded.insert(recorded.end(), workers.begin(), workers.end());
+		frame.render(clear, recorded);
+		if (readback && readback->requested()) {
+			frame.colour_to_readback(present);
+			readback->record(sync.cmd.primary, present);
+			if (!offscreen) { frame.readback_to_present(present); }
+		} else if (!offscreen) {
+			frame.colour_to_present({present.image, present.view, present.extent});
+		}
 
 		sync.cmd.primary.end();
 		framebuffer = {};
@@ -289,8 +330,170 @@ ShaderInput::Textures make_shader_textures(GfxDevice const* device) {
 	Bitmap::rgba_to_byte(magenta_v, imageBytes);
 	cb.writer.write(ret.magenta.image.get(), std::span<std::byte const>(imageBytes), {}, vk::ImageLayout::eShaderReadOnlyOptimal);
 
+	static constexpr auto vertex_v = Vertex::make();
+	ret.vertex = device->make_buffer(vk::BufferCreateInfo({}, sizeof(vertex_v), vk::BufferUsageFlagBits::eVertexBuffer), true);
+	if (!ret.vertex || !ret.vertex->write(&vertex_v, sizeof(vertex_v))) { return {}; }
+
 	return ret;
 }
+
+AntiAliasing anti_aliasing(vk::SampleCountFlagBits samples) {
+	switch (samples) {
+	case vk::SampleCountFlagBits::e16: return AntiAliasing::e16x;
+	case vk::SampleCountFlagBits::e8: return AntiAliasing::e8x;
+	case vk::SampleCountFlagBits::e4: return AntiAliasing::e4x;
+	case vk::SampleCountFlagBits::e2: return AntiAliasing::e2x;
+	case vk::SampleCountFlagBits::e1:
+	default: return AntiAliasing::eNone;
+	}
+}
+
+///
+/// \brief Stand-in for swapchain images when rendering without a surface
+///
+struct OffscreenTarget {
+	GfxDevice const* device{};
+	Rotator<ImageCache> images{};
+
+	static OffscreenTarget make(GfxDevice const* device, vk::Format format) {
+		assert(device);
+		auto ret = OffscreenTarget{device};
+		for (std::size_t i = 0; i < device->buffering; ++i) {
+			auto& image = ret.images.push(ImageCache{.device = device});
+			image.set_colour();
+			image.info.info.format = format;
+		}
+		return ret;
+	}
+
+	explicit operator bool() const { return device && !images.storage.empty(); }
+
+	ImageView acquire(Extent const extent) {
+		if (!*this || extent.x == 0 || extent.y == 0) { return {}; }
+		return images.get().refresh(extent);
+	}
+
+	void submit(vk::CommandBuffer const cb, vk::Fence const drawn) const {
+		if (!device) { return; }
+		auto const si = vk::SubmitInfo(0U, nullptr, {}, 1U, &cb);
+		auto lock = std::scoped_lock(*device->device.queue_mutex);
+		auto res = device->device.queue.queue.submit(1U, &si, drawn);
+		if (res != vk::Result::eSuccess) { VF_TRACE("vf::(internal)", trace::Type::eError, "Queue submit failure!"); }
+	}
+
+	void next() { images.next(); }
+};
+
+///
+/// \brief Pipelines, descriptor sets, and default textures shared by all instance types
+///
+struct RenderStack {
+	std::vector<vk::UniqueDescriptorSetLayout> set_layouts{};
+	VertexInputStorage vertex_input{};
+	PipelineFactory pipeline_factory{};
+	DescriptorSetFactory set_factory{};
+	ShaderInput::Textures shader_textures{};
+	RenderPass render_pass{};
+	DrawList draw_list{};
+	std::vector<ktl::kunique_ptr<RenderWorker>> workers{};
+	std::vector<vk::CommandBuffer> recorded{};
+	std::size_t active_workers{};
+	std::vector<std::shared_future<std::size_t>> prewarms{};
+	RenderStats stats{};
+
+	bool init(GfxDevice const& device, InstanceFlags flags, char const* pipeline_cache) {
+		draw_list.batch = flags.test(InstanceFlag::eBatchDraws);
+		draw_list.sort = flags.test(InstanceFlag::eSortDraws);
+		draw_list.cull = flags.test(InstanceFlag::eCullInstances);
+		auto const srr = flags.test(InstanceFlag::eSuperSampling);
+		set_layouts = make_set_layouts(device.device.device);
+		vertex_input = VertexInputStorage::make();
+		auto sl = make_set_layouts(set_layouts);
+		auto cache_path = pipeline_cache ? std::string(pipeline_cache) : std::string{};
+		pipeline_factory = PipelineFactory::make(device.device, vertex_input(), std::move(sl), device.colour_samples, srr, std::move(cache_path));
+		if (!pipeline_factory) { return false; }
+
+		set_factory = DescriptorSetFactory::make(device, pipeline_factory.set_layouts);
+		if (!set_factory) { return false; }
+
+		shader_textures = make_shader_textures(&device);
+		return static_cast<bool>(shader_textures);
+	}
+
+	Surface begin(Instance* instance, GfxDevice const& device, vk::RenderPass rp, vk::CommandBuffer cmd, Extent extent, Camera& camera, std::mutex* mutex) {
+		auto proj = set_factory.post_increment(0);
+		auto const mat_p = projection(extent);
+		proj.write(0, &mat_p, sizeof(mat_p));
+
+		auto const input = ShaderInput{proj, &shader_textures};
+		auto const cam = RenderCam{extent, &camera};
+		auto const lwl = std::pair(device.device_limits->lineWidthRange[0], device.device_limits->lineWidthRange[1]);
+		render_pass = RenderPass{instance, &device, &pipeline_factory, &set_factory, rp, cmd, input, cam, lwl, mutex};
+		draw_list.clear();
+		render_pass.draw_list = &draw_list;
+		return Surface{&render_pass};
+	}
+
+	Surface begin_worker(GfxDevice const& device, Framebuffer const& framebuffer) {
+		if (!render_pass.instance || !framebuffer) { return {}; }
+		if (active_workers == workers.size()) {
+			auto worker = RenderWorker::make(device, pipeline_factory.set_layouts);
+			if (!worker) { return {}; }
+			workers.push_back(std::move(worker));
+		}
+		return workers[active_workers++]->begin(render_pass, framebuffer);
+	}
+
+	std::span<vk::CommandBuffer const> end_workers() {
+		recorded.clear();
+		for (std::size_t i = 0; i < active_workers; ++i) {
+			auto& worker = *workers[i];
+			if (worker.end()) {
+				VF_TRACE("vf::(internal)", trace::Type::eWarn, "Worker Surface not destroyed before end of pass; discarding its draws");
+				continue;
+			}
+			recorded.push_back(worker.render_pass.command_buffer);
+		}
+		return recorded;
+	}
+
+	void next() {
+		stats = render_pass.stats;
+		for (std::size_t i = 0; i < active_workers; ++i) { stats += workers[i]->render_pass.stats; }
+		set_factory.next();
+		for (auto& worker : workers) { worker->next(); }
+		active_workers = {};
+	}
+
+	std::shared_future<std::size_t> prewarm(GfxDevice const& device, vk::RenderPass rp, std::span<RenderState const> states, std::span<Handle<Shader> const> shaders,
+											std::span<VertexFormat const> formats) {
+		static constexpr VertexFormat standard_v[] = {VertexFormat::eStandard};
+		if (formats.empty()) { formats = standard_v; }
+		auto specs = std::vector<PipelineFactory::Spec>{};
+		specs.reserve(states.size() * (shaders.size() + 1) * formats.size());
+		for (auto const format : formats) {
+			for (auto const& state : states) {
+				auto const own = state.descriptor_set ? state.descriptor_set->shader() : Handle<Shader>{};
+				specs.push_back(PipelineFactory::Spec::make(state, own, device.default_z_order, format));
+				for (auto const shader : shaders) { specs.push_back(PipelineFactory::Spec::make(state, shader, device.default_z_order, format)); }
+			}
+		}
+		std::erase_if(prewarms, [](auto const& f) { return f.wait_for(std::chrono::seconds()) == std::future_status::ready; });
+		auto func = [this, specs = std::move(specs), rp] { return pipeline_factory.prewarm(specs, rp); };
+		return prewarms.emplace_back(std::async(std::launch::async, std::move(func)).share());
+	}
+
+	void wait_prewarms() {
+		for (auto const& prewarm : prewarms) { prewarm.wait(); }
+		prewarms.clear();
+	}
+};
+
+std::shared_future<std::size_t> ready_future(std::size_t value) {
+	auto promise = std::promise<std::size_t>{};
+	promise.set_value(value);
+	return promise.get_future().share();
+}
 } // namespace
 
 struct VulkifyInstance::Impl {
@@ -303,13 +506,9 @@ struct VulkifyInstance::Impl {
 	FtUnique<FtLib> freetype{};
 
 	VulkanSwapchain::Acquire acquired{};
-	std::vector<vk::UniqueDescriptorSetLayout> set_layouts{};
-	VertexInputStorage vertex_input{};
-	PipelineFactory pipeline_factory{};
-	DescriptorSetFactory set_factory{};
-	ShaderInput::Textures shader_textures{};
+	RenderStack stack{};
+	ReadbackRing readback{};
 	Camera camera{};
-	RenderPass render_pass{};
 };
 
 VulkifyInstance::Result VulkifyInstance::make(CreateInfo const& create_info) {
@@ -364,23 +563,12 @@ VulkifyInstance::Result VulkifyInstance::make(CreateInfo const& create_info) {
 		impl->renderer = std::move(renderer);
 		impl->device.device->texture_format = texture_format(impl->swapchain.info.imageFormat);
 		impl->device.device->buffering = impl->renderer.frame_sync.storage.size();
+		if (impl->swapchain.info.imageUsage & vk::ImageUsageFlagBits::eTransferSrc) {
+			impl->readback = ReadbackRing::make(&impl->device.device.get(), impl->swapchain.info.imageFormat);
+		}
 	}
 	{
-		impl->set_layouts = make_set_layouts(*impl->vulkan.device);
-		impl->vertex_input = VertexInputStorage::make();
-		auto const srr = create_info.instance_flags.test(InstanceFlag::eSuperSampling);
-		auto sl = make_set_layouts(impl->set_layouts);
-		auto const csamples = impl->device.device->colour_samples;
-		impl->pipeline_factory = PipelineFactory::make(impl->device.device->device, impl->vertex_input(), std::move(sl), csamples, srr);
-		if (!impl->pipeline_factory) { return Error::eVulkanInitFailure; }
-	}
-
-	{
-		impl->set_factory = DescriptorSetFactory::make(impl->device.device, impl->pipeline_factory.set_layouts);
-		if (!impl->set_factory) { return Error::eVulkanInitFailure; }
-
-		impl->shader_textures = make_shader_textures(&impl->device.device.get());
-		if (!impl->shader_textures) { return Error::eVulkanInitFailure; }
+		if (!impl->stack.init(impl->device.device, create_info.instance_flags, create_info.pipeline_cache)) { return Error::eVulkanInitFailure; }
 	}
 
 	impl->freetype = std::move(freetype);
@@ -393,7 +581,9 @@ VulkifyInstance::VulkifyInstance(ktl::kunique_ptr<Impl> impl) noexcept : m_impl(
 }
 
 VulkifyInstance::~VulkifyInstance() {
+	m_impl->stack.wait_prewarms();
 	m_impl->vulkan.device->waitIdle();
+	m_impl->stack.pipeline_factory.save_cache();
 	g_window = {};
 	g_gamepads = {};
 }
@@ -426,16 +616,7 @@ glm::vec2 VulkifyInstance::cursor_position() const {
 MonitorList VulkifyInstance::monitors() const { return m_impl->window->monitors(); }
 WindowFlags VulkifyInstance::window_flags() const { return m_impl->window->flags(); }
 
-AntiAliasing VulkifyInstance::anti_aliasing() const {
-	switch (m_impl->device.device->colour_samples) {
-	case vk::SampleCountFlagBits::e16: return AntiAliasing::e16x;
-	case vk::SampleCountFlagBits::e8: return AntiAliasing::e8x;
-	case vk::SampleCountFlagBits::e4: return AntiAliasing::e4x;
-	case vk::SampleCountFlagBits::e2: return AntiAliasing::e2x;
-	case vk::SampleCountFlagBits::e1:
-	default: return AntiAliasing::eNone;
-	}
-}
+AntiAliasing VulkifyInstance::anti_aliasing() const { return vf::anti_aliasing(m_impl->device.device->colour_samples); }
 
 VSync VulkifyInstance::vsync() const { return to_vsync(m_impl->swapchain.info.presentMode); }
 std::vector<Gpu> VulkifyInstance::gpu_list() const { return m_impl->vulkan.available_devices(); }
@@ -480,33 +661,46 @@ vf::Surface VulkifyInstance::begin_pass(Rgba clear) {
 	m_impl->vulkan.util->defer.decrement();
 	m_impl->renderer.clear = clear;
 
-	auto proj = m_impl->set_factory.post_increment(0);
-	auto const mat_p = projection(extent);
-	proj.write(0, &mat_p, sizeof(mat_p));
-
-	auto const input = ShaderInput{proj, &m_impl->shader_textures};
-	auto const cam = RenderCam{extent, &m_impl->camera};
-	auto const lwl = std::pair(m_impl->device.device->device_limits->lineWidthRange[0], m_impl->device.device->device_limits->lineWidthRange[1]);
 	auto* mutex = &m_impl->vulkan.util->mutex.render;
 	auto const& device = m_impl->device.device.get();
-	m_impl->render_pass =
-		RenderPass{this, &device, &m_impl->pipeline_factory, &m_impl->set_factory, *sr.renderer.render_pass, std::move(cmd), input, cam, lwl, mutex};
-	return Surface{&m_impl->render_pass};
+	return m_impl->stack.begin(this, device, *sr.renderer.render_pass, cmd, extent, m_impl->camera, mutex);
 }
 
 bool VulkifyInstance::end_pass() {
 	if (!m_impl->acquired) { return false; }
-	auto const cb = m_impl->renderer.end_render();
+	auto const cb = m_impl->renderer.end_render(&m_impl->readback, m_impl->stack.end_workers());
 	if (!cb) { return false; }
 	auto const sync = m_impl->renderer.sync();
 	m_impl->swapchain.submit(cb, sync);
+	m_impl->readback.submit();
 	m_impl->swapchain.present(m_impl->acquired, sync.present, m_impl->window->framebuffer_size());
 	m_impl->acquired = {};
 	m_impl->renderer.next();
-	m_impl->set_factory.next();
+	m_impl->stack.next();
 	m_impl->acquired = {};
 	return true;
 }
+
+Surface VulkifyInstance::worker_surface() {
+	if (!m_impl->acquired) { return {}; }
+	return m_impl->stack.begin_worker(m_impl->device.device.get(), m_impl->renderer.framebuffer);
+}
+
+bool VulkifyInstance::request_readback() {
+	if (!m_impl->acquired) { return false; }
+	return m_impl->readback.request();
+}
+
+std::size_t VulkifyInstance::poll_readbacks(OnReadback const& callback) { return m_impl->readback.poll(callback); }
+
+RenderStats VulkifyInstance::render_stats() const { return m_impl->stack.stats; }
+
+std::shared_future<std::size_t> VulkifyInstance::prewarm(std::span<RenderState const> states, std::span<Handle<Shader> const> shaders,
+														 std::span<VertexFormat const> formats) {
+	auto const rp = *m_impl->renderer.renderer.render_pass;
+	return m_impl->stack.prewarm(m_impl->device.device.get(), rp, states, shaders, formats);
+}
+
 // gamepad
 
 GamepadMap Gamepad::map() { return Window::gamepads(); }
@@ -536,10 +730,153 @@ std::size_t GamepadMap::count() const { return static_cast<std::size_t>(std::cou
 
 GfxDevice const& VulkifyInstance::gfx_device() const { return m_impl->device.device; }
 
+// headless
+
+struct HeadlessInstance::Impl {
+	VulkanInstance vulkan{};
+	UniqueGfxDevice device{};
+	SwapchainRenderer renderer{};
+	OffscreenTarget target{};
+	RenderStack stack{};
+	ReadbackRing readback{};
+	FtUnique<FtLib> freetype{};
+
+	ImageView acquired{};
+
+	static vf::Result<ktl::kunique_ptr<Impl>> make(CreateInfo const& create_info);
+};
+
+auto HeadlessInstance::Impl::make(CreateInfo const& create_info) -> vf::Result<ktl::kunique_ptr<Impl>> {
+	auto freetype = FtUnique<FtLib>{FtLib::make()};
+	if (!freetype) { return Error::eFreetypeInitFailure; }
+
+	auto vkinfo = VulkanInstance::Info{};
+	vkinfo.headless = true;
+	auto builder = VulkanInstance::Builder::make(std::move(vkinfo));
+	if (!builder) { return builder.error(); }
+	if (builder->devices.empty()) { return Error::eNoVulkanSupport; }
+	auto selected = select_device(builder->devices, create_info.gpu_selector);
+	auto vulkan = builder.value()(std::move(selected));
+	if (!vulkan) { return vulkan.error(); }
+
+	auto ret = ktl::make_unique<Impl>(Impl{std::move(*vulkan)});
+	{
+		ret->device = UniqueGfxDevice::make(ret->vulkan, freetype->lib, get_samples(create_info.desired_aa));
+		if (!ret->device) { return Error::eVulkanInitFailure; }
+		ret->device.device->buffering = 2;
+		ret->device.device->default_z_order = create_info.default_z_order;
+	}
+	{
+		bool const linear = create_info.instance_flags.test(InstanceFlag::eLinearSwapchain);
+		auto const format = linear ? vk::Format::eR8G8B8A8Unorm : vk::Format::eR8G8B8A8Srgb;
+		ret->device.device->device.flags.assign(VulkanDevice::Flag::eLinearSwp, linear);
+		auto renderer = SwapchainRenderer::make(&ret->device.device.get(), format, true);
+		if (!renderer) { return Error::eVulkanInitFailure; }
+		ret->renderer = std::move(renderer);
+		ret->device.device->texture_format = texture_format(format);
+		ret->device.device->buffering = ret->renderer.frame_sync.storage.size();
+		ret->target = OffscreenTarget::make(&ret->device.device.get(), format);
+		if (!ret->target) { return Error::eVulkanInitFailure; }
+		ret->readback = ReadbackRing::make(&ret->device.device.get(), format);
+	}
+	{
+		if (!ret->stack.init(ret->device.device, create_info.instance_flags, create_info.pipeline_cache)) { return Error::eVulkanInitFailure; }
+	}
+
+	ret->freetype = std::move(freetype);
+	return vf::Result<ktl::kunique_ptr<Impl>>(std::move(ret));
+}
+
+HeadlessInstance::Result HeadlessInstance::make(CreateInfo const& create_info, Time autoclose) {
+	auto ret = ktl::make_unique<HeadlessInstance>(autoclose);
+	ret->m_framebuffer_extent = ret->m_window_extent = create_info.extent;
+	auto impl = Impl::make(create_info);
+	if (impl) {
+		ret->m_impl = std::move(impl.value());
+		ret->m_gpu = ret->m_impl->vulkan.gpu.gpu;
+		VF_TRACEI("vf::(internal)", "Headless rendering on [{}]", ret->m_gpu.name);
+	} else {
+		VF_TRACE("vf::(internal)", trace::Type::eWarn, "Failed to create headless Vulkan device, rendering will be disabled");
+	}
+	return Result(std::move(ret));
+}
+
 HeadlessInstance::HeadlessInstance(Time autoclose) : m_autoclose(autoclose) {}
 
+HeadlessInstance::~HeadlessInstance() {
+	if (m_impl) {
+		m_impl->stack.wait_prewarms();
+		m_impl->vulkan.device->waitIdle();
+		m_impl->stack.pipeline_factory.save_cache();
+	}
+}
+
 GfxDevice const& HeadlessInstance::gfx_device() const {
 	static auto const s_inactive = GfxDevice{};
+	if (m_impl) { return m_impl->device.device; }
 	return s_inactive;
 }
+
+AntiAliasing HeadlessInstance::anti_aliasing() const {
+	if (m_impl) { return vf::anti_aliasing(m_impl->device.device->colour_samples); }
+	return AntiAliasing::eNone;
+}
+
+Surface HeadlessInstance::begin_pass(Rgba clear) {
+	if (!m_impl) { return {}; }
+	if (m_impl->acquired.image) {
+		VF_TRACE("vf::(internal)", trace::Type::eWarn, "RenderPass already begun");
+		return {};
+	}
+
+	m_impl->acquired = m_impl->target.acquire(m_framebuffer_extent);
+	if (!m_impl->acquired.image) { return {}; }
+	auto const extent = Extent{m_impl->acquired.extent.width, m_impl->acquired.extent.height};
+	auto& sr = m_impl->renderer;
+	auto cmd = sr.begin_render(m_impl->acquired);
+	m_impl->vulkan.util->defer.decrement();
+	sr.clear = clear;
+
+	auto* mutex = &m_impl->vulkan.util->mutex.render;
+	auto const& device = m_impl->device.device.get();
+	return m_impl->stack.begin(this, device, *sr.renderer.render_pass, cmd, extent, m_camera, mutex);
+}
+
+bool HeadlessInstance::end_pass() {
+	if (!m_impl) { return true; }
+	if (!m_impl->acquired.image) { return false; }
+	auto const cb = m_impl->renderer.end_render(&m_impl->readback, m_impl->stack.end_workers());
+	m_impl->acquired = {};
+	if (!cb) { return false; }
+	m_impl->target.submit(cb, m_impl->renderer.sync().drawn);
+	m_impl->readback.submit();
+	m_impl->renderer.next();
+	m_impl->target.next();
+	m_impl->stack.next();
+	return true;
+}
+
+Surface HeadlessInstance::worker_surface() {
+	if (!m_impl || !m_impl->acquired.image) { return {}; }
+	return m_impl->stack.begin_worker(m_impl->device.device.get(), m_impl->renderer.framebuffer);
+}
+
+bool HeadlessInstance::request_readback() {
+	if (!m_impl || !m_impl->acquired.image) { return false; }
+	return m_impl->readback.request();
+}
+
+std::size_t HeadlessInstance::poll_readbacks(OnReadback const& callback) {
+	if (!m_impl) { return 0; }
+	return m_impl->readback.poll(callback);
+}
+
+RenderStats HeadlessInstance::render_stats() const { return m_impl ? m_impl->stack.stats : RenderStats{}; }
+
+std::shared_future<std::size_t> HeadlessInstance::prewarm(std::span<RenderState const> states, std::span<Handle<Shader> const> shaders,
+														  std::span<VertexFormat const> formats) {
+	if (!m_impl) { return ready_future(0); }
+	auto const rp = *m_impl->renderer.renderer.render_pass;
+	return m_impl->stack.prewarm(m_impl->device.device.get(), rp, states, shaders, formats);
+}
 } // namespace vf
@@ -24,12 +24,17 @@ target_sources(${PROJECT_NAME} PRIVATE
   include/vulkify/graphics/camera.hpp
   include/vulkify/graphics/descriptor_set.hpp
   include/vulkify/graphics/drawable.hpp
+  include/vulkify/graphics/geometry_arena.hpp
   include/vulkify/graphics/geometry_buffer.hpp
   include/vulkify/graphics/geometry.hpp
   include/vulkify/graphics/gfx_resource.hpp
   include/vulkify/graphics/image.hpp
+  include/vulkify/graphics/indirect_buffer.hpp
+  include/vulkify/graphics/instance_buffer.hpp
+  include/vulkify/graphics/model_storage.hpp
   include/vulkify/graphics/primitive.hpp
   include/vulkify/graphics/render_state.hpp
+  include/vulkify/graphics/render_stats.hpp
   include/vulkify/graphics/shader.hpp
   include/vulkify/graphics/surface.hpp
   include/vulkify/graphics/texture.hpp
@@ -37,6 +42,7 @@ target_sources(${PROJECT_NAME} PRIVATE
 
   include/vulkify/graphics/primitives/all.hpp
   include/vulkify/graphics/primitives/circle_shape.hpp
+  include/vulkify/graphics/primitives/indirect_mesh.hpp
   include/vulkify/graphics/primitives/mesh.hpp
   include/vulkify/graphics/primitives/prop.hpp
   include/vulkify/graphics/primitives/quad_shape.hpp
@@ -60,6 +66,7 @@ target_sources(${PROJECT_NAME} PRIVATE
   include/vulkify/instance/instance.hpp
   include/vulkify/instance/key_event.hpp
   include/vulkify/instance/monitor.hpp
+  include/vulkify/instance/readback.hpp
   include/vulkify/instance/vf_instance.hpp
   include/vulkify/instance/video_mode.hpp
 